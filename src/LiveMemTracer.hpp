@@ -12,17 +12,73 @@ Code and documentation https://github.com/cesarl/LiveMemTracer
 #define LMT_PLATFORM_ORBIS
 #endif
 
+// Allocation timestamp is saved in the header
+#if defined(LMT_LIFETIME_ACTIVATED) || defined(LMT_LIVE_TABLE_ACTIVATED)
+#define LMT_HEADER_TIME 1
+#endif
+
 #if LMT_ENABLED == 0
+#include <cstdlib>    //malloc, aligned_alloc, posix_memalign
+#if defined(LMT_PLATFORM_WINDOWS)
+#include <cerrno>     //ENOMEM
+#include <malloc.h>   //_msize
+#elif defined(__APPLE__)
+#include <malloc/malloc.h> //malloc_size
+#elif defined(__FreeBSD__)
+#include <malloc_np.h> //malloc_usable_size
+#else
+#include <malloc.h>   //malloc_usable_size
+#endif
 #define LMT_ALLOC(size)::malloc(size)
 #define LMT_ALLOC_ALIGNED(size, alignment)::malloc(size)
 #define LMT_DEALLOC(ptr)::free(ptr)
 #define LMT_DEALLOC_ALIGNED(ptr)::free(ptr)
 #define LMT_REALLOC(ptr, size)::realloc(ptr, size)
-#define LMT_REALLOC_ALIGNED(ptr, size, alignment)::realloc(ptr, size, alignment)
+#define LMT_REALLOC_ALIGNED(ptr, size, alignment)::realloc(ptr, size)
+#define LMT_CALLOC(count, size)::calloc(count, size)
+#if defined(LMT_PLATFORM_WINDOWS)
+// LMT_DEALLOC_ALIGNED stays ::free, so alignment can't be honoured with _aligned_malloc
+#define LMT_ALIGNED_ALLOC(alignment, size)::malloc(size)
+#define LMT_POSIX_MEMALIGN(memptr, alignment, size)((*(memptr) = ::malloc(size)) != nullptr ? 0 : ENOMEM)
+#define LMT_USABLE_SIZE(ptr)::_msize(ptr)
+#else
+#define LMT_ALIGNED_ALLOC(alignment, size)::aligned_alloc(alignment, size)
+#define LMT_POSIX_MEMALIGN(memptr, alignment, size)::posix_memalign(memptr, alignment, size)
+#if defined(__APPLE__)
+#define LMT_USABLE_SIZE(ptr)::malloc_size(ptr)
+#else
+#define LMT_USABLE_SIZE(ptr)::malloc_usable_size(ptr)
+#endif
+#endif
+#define LMT_ALLOC_HEAP(heap, size)heap::allocate(size)
+#define LMT_ALLOC_ALIGNED_HEAP(heap, size, alignment)heap::allocate(size)
+#define LMT_DEALLOC_HEAP(heap, ptr)heap::deallocate(ptr)
+#define LMT_DEALLOC_ALIGNED_HEAP(heap, ptr)heap::deallocate(ptr)
+#define LMT_REALLOC_HEAP(heap, ptr, size)heap::reallocate(ptr, size)
+#define LMT_REALLOC_ALIGNED_HEAP(heap, ptr, size, alignment)heap::reallocate(ptr, size)
+#define LMT_REGISTER_HEAP(heap)do{}while(0)
+#define LMT_SCOPE_TAG(name)do{}while(0)
+#define LMT_SET_TAG_BUDGET(name, budget)do{}while(0)
+#define LMT_SET_TAG_BUDGET_CALLBACK(callback)do{}while(0)
+#define LMT_POOL_ALLOC(poolId, ptr, size)do{}while(0)
+#define LMT_POOL_FREE(poolId, ptr)do{}while(0)
+#define LMT_REGISTER_POOL(poolId, name, base, capacity)do{}while(0)
+#define LMT_TRACK_RESOURCE(kind, handle, size)do{}while(0)
+#define LMT_UNTRACK_RESOURCE(kind, handle)do{}while(0)
+#define LMT_REGISTER_RESOURCE_KIND(kind, name)do{}while(0)
+#define LMT_FOLD_PREFIX(prefix)do{}while(0)
+#define LMT_FOLD_RANGE(begin, end)do{}while(0)
 #define LMT_DISPLAY(dt)do{}while(0)
 #define LMT_EXIT()do{}while(0)
 #define LMT_INIT()do{}while(0)
 #define LMT_FLUSH()do{}while(0)
+#define LMT_EXPORT_SIZE_CLASSES(path)(false)
+#define LMT_FRAME_MARK()do{}while(0)
+#define LMT_SET_FRAME_BUDGET(bytes)do{}while(0)
+#define LMT_MARK()(0u)
+#define LMT_LIVE_SINCE_MARK(generation)(0)
+#define LMT_WRITE_LEAK_REPORT(path)(false)
+#define LMT_DUMP_HEAP(path)(false)
 
 #else //LMT_ENABLED
 
@@ -32,15 +88,50 @@ Code and documentation https://github.com/cesarl/LiveMemTracer
 #define LMT_DEALLOC_ALIGNED(ptr)::LiveMemTracer::deallocAligned(ptr)
 #define LMT_REALLOC(ptr, size)::LiveMemTracer::realloc(ptr, size)
 #define LMT_REALLOC_ALIGNED(ptr, size, alignment)::LiveMemTracer::reallocAligned(ptr, size, alignment)
+#define LMT_CALLOC(count, size)::LiveMemTracer::calloc(count, size)
+#define LMT_ALIGNED_ALLOC(alignment, size)::LiveMemTracer::alignedAlloc(alignment, size)
+#define LMT_POSIX_MEMALIGN(memptr, alignment, size)::LiveMemTracer::posixMemalign(memptr, alignment, size)
+#define LMT_USABLE_SIZE(ptr)::LiveMemTracer::usableSize(ptr)
+#define LMT_ALLOC_HEAP(heap, size)::LiveMemTracer::alloc<heap>(size)
+#define LMT_ALLOC_ALIGNED_HEAP(heap, size, alignment)::LiveMemTracer::allocAligned<heap>(size, alignment)
+#define LMT_DEALLOC_HEAP(heap, ptr)::LiveMemTracer::dealloc<heap>(ptr)
+#define LMT_DEALLOC_ALIGNED_HEAP(heap, ptr)::LiveMemTracer::deallocAligned<heap>(ptr)
+#define LMT_REALLOC_HEAP(heap, ptr, size)::LiveMemTracer::realloc<heap>(ptr, size)
+#define LMT_REALLOC_ALIGNED_HEAP(heap, ptr, size, alignment)::LiveMemTracer::reallocAligned<heap>(ptr, size, alignment)
+#define LMT_REGISTER_HEAP(heap)::LiveMemTracer::registerHeap(heap::ID, heap::name())
+#define LMT_CONCAT_IMPL(a, b) a##b
+#define LMT_CONCAT(a, b) LMT_CONCAT_IMPL(a, b)
+#define LMT_SCOPE_TAG(name)\
+	static const uint8_t LMT_CONCAT(lmtTagId, __LINE__) = ::LiveMemTracer::registerTag(name);\
+	::LiveMemTracer::TagScope LMT_CONCAT(lmtTagScope, __LINE__)(LMT_CONCAT(lmtTagId, __LINE__))
+#define LMT_SET_TAG_BUDGET(name, budget)::LiveMemTracer::setTagBudget(name, budget)
+#define LMT_SET_TAG_BUDGET_CALLBACK(callback)::LiveMemTracer::setTagBudgetCallback(callback)
+#define LMT_POOL_ALLOC(poolId, ptr, size)::LiveMemTracer::poolAlloc(poolId, ptr, size)
+#define LMT_POOL_FREE(poolId, ptr)::LiveMemTracer::poolFree(poolId, ptr)
+#define LMT_REGISTER_POOL(poolId, name, base, capacity)::LiveMemTracer::registerPool(poolId, name, base, capacity)
+#define LMT_TRACK_RESOURCE(kind, handle, size)::LiveMemTracer::trackResource(kind, size_t(handle), size)
+#define LMT_UNTRACK_RESOURCE(kind, handle)::LiveMemTracer::untrackResource(kind, size_t(handle))
+#define LMT_REGISTER_RESOURCE_KIND(kind, name)::LiveMemTracer::registerResourceKind(kind, name)
+#define LMT_FOLD_PREFIX(prefix)::LiveMemTracer::addFoldPrefix(prefix)
+#define LMT_FOLD_RANGE(begin, end)::LiveMemTracer::addFoldRange(begin, end)
 #define LMT_DISPLAY(dt)::LiveMemTracer::display(dt)
 #define LMT_EXIT()::LiveMemTracer::exit()
 #define LMT_INIT() ::LiveMemTracer::init()
 #define LMT_FLUSH()::LiveMemTracer::getChunk(true)
+#define LMT_EXPORT_SIZE_CLASSES(path)::LiveMemTracer::exportSizeClasses(path)
+#define LMT_FRAME_MARK()::LiveMemTracer::frameMark()
+#define LMT_SET_FRAME_BUDGET(bytes)::LiveMemTracer::setFrameBudget(bytes)
+#define LMT_MARK()::LiveMemTracer::mark()
+#define LMT_LIVE_SINCE_MARK(generation)::LiveMemTracer::liveSinceMark(generation)
+#define LMT_WRITE_LEAK_REPORT(path)::LiveMemTracer::writeLeakReport(path)
+#define LMT_DUMP_HEAP(path)::LiveMemTracer::dumpHeap(path)
 
 #ifdef LMT_IMPL
 
 #include <atomic>     //std::atomic
 #include <cstdlib>    //malloc etc...
+#include <cerrno>     //EINVAL, ENOMEM
+#include <cstdio>     //snprintf, fopen
 #include <algorithm>
 #ifdef LMT_PLATFORM_WINDOWS
 #pragma warning(push)
@@ -50,6 +141,20 @@ Code and documentation https://github.com/cesarl/LiveMemTracer
 #ifdef LMT_PLATFORM_WINDOWS
 #pragma warning(pop)
 #endif
+#if !defined(LMT_RESERVE_MEMORY) && !defined(LMT_PLATFORM_WINDOWS)
+#include <sys/mman.h> //mmap
+#endif
+#ifdef LMT_HEADER_TIME
+#include <chrono>     //steady_clock, to convert timestamps
+#ifndef LMT_TIMESTAMP
+#ifdef LMT_PLATFORM_WINDOWS
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define LMT_TIMESTAMP() __rdtsc()
+#endif
+#endif
 
 #ifndef LMT_ALLOC_NUMBER_PER_CHUNK
 #define LMT_ALLOC_NUMBER_PER_CHUNK 1024 * 8
@@ -59,6 +164,10 @@ Code and documentation https://github.com/cesarl/LiveMemTracer
 #define LMT_STACK_SIZE_PER_ALLOC 50
 #endif
 
+#ifndef LMT_STACK_ARENA_CHUNK_SIZE
+#define LMT_STACK_ARENA_CHUNK_SIZE 1024 * 64
+#endif
+
 #ifndef LMT_CHUNK_NUMBER_PER_THREAD
 #define LMT_CHUNK_NUMBER_PER_THREAD 8
 #endif
@@ -79,6 +188,79 @@ Code and documentation https://github.com/cesarl/LiveMemTracer
 #define LMT_TREE_DICTIONARY_SIZE 1024 * 16 * 16
 #endif
 
+#ifndef LMT_HEAP_NUMBER
+#define LMT_HEAP_NUMBER 8
+#endif
+
+#ifndef LMT_TAG_NUMBER
+#define LMT_TAG_NUMBER 64
+#endif
+
+#ifndef LMT_POOL_NUMBER
+#define LMT_POOL_NUMBER 16
+#endif
+
+#ifndef LMT_RESOURCE_KIND_NUMBER
+#define LMT_RESOURCE_KIND_NUMBER 8
+#endif
+
+#ifndef LMT_POOL_TABLE_SIZE
+#define LMT_POOL_TABLE_SIZE 1024 * 64
+#endif
+
+#ifndef LMT_INTERNAL_PAGE_SIZE
+#define LMT_INTERNAL_PAGE_SIZE 1024 * 64
+#endif
+
+#ifndef LMT_FOLD_RULE_NUMBER
+#define LMT_FOLD_RULE_NUMBER 16
+#endif
+
+#ifndef LMT_SIZE_CLASS_EXPORT_PATH
+#define LMT_SIZE_CLASS_EXPORT_PATH "LMT_SizeClasses.csv"
+#endif
+
+#ifndef LMT_PEAK_SNAPSHOT_MARGIN
+#define LMT_PEAK_SNAPSHOT_MARGIN 1024 * 1024
+#endif
+
+#ifndef LMT_PEAK_SNAPSHOT_SIZE
+#define LMT_PEAK_SNAPSHOT_SIZE 32
+#endif
+
+#ifndef LMT_FRAME_HISTORY
+#define LMT_FRAME_HISTORY 256
+#endif
+
+#ifndef LMT_FRAME_TOP_STACKS
+#define LMT_FRAME_TOP_STACKS 4
+#endif
+
+// Frames count allocations and frees of chunk events
+#if defined(LMT_FRAME_ACTIVATED) && !defined(LMT_CHURN_ACTIVATED)
+#define LMT_CHURN_ACTIVATED 1
+#endif
+
+#ifndef LMT_GENERATION_NUMBER
+#define LMT_GENERATION_NUMBER 8
+#endif
+
+#ifndef LMT_LEAK_REPORT_PATH
+#define LMT_LEAK_REPORT_PATH nullptr
+#endif
+
+#ifndef LMT_LIVE_TABLE_SIZE
+#define LMT_LIVE_TABLE_SIZE 1024 * 1024
+#endif
+
+#ifndef LMT_HEAP_DUMP_PATH
+#define LMT_HEAP_DUMP_PATH "LMT_Heap.csv"
+#endif
+
+#ifndef LMT_STATS_SLOT_NUMBER
+#define LMT_STATS_SLOT_NUMBER 16
+#endif
+
 #ifndef LMT_IMGUI
 #define LMT_IMGUI 1
 #endif
@@ -123,30 +305,136 @@ static_assert(false, "You have to define if target is x64 or x86");
 #define LMT_TLS __declspec(thread)
 #define LMT_INLINE __forceinline
 #define LMT_ATOMIC_INITIALIZER(value) value
+#define LMT_ALIGN(alignment) __declspec(align(alignment))
+// snprintf is only available since Visual Studio 2015
+#define LMT_SNPRINTF(buffer, size, format, ...) _snprintf_s(buffer, size, _TRUNCATE, format, __VA_ARGS__)
 #elif defined(LMT_PLATFORM_ORBIS)
 #undef LMT_TLS
 #undef LMT_INLINE
 #define LMT_TLS __thread
 #define LMT_INLINE __attribute__((__always_inline__))
 #define LMT_ATOMIC_INITIALIZER(value) {value}
+#define LMT_ALIGN(alignment) __attribute__((aligned(alignment)))
+#define LMT_SNPRINTF(buffer, size, format, ...) snprintf(buffer, size, format, __VA_ARGS__)
 #else
 #define LMT_TLS
 #define LMT_INLINE
 #define LMT_ATOMIC_INITIALIZER(value)()
+#define LMT_ALIGN(alignment)
+#define LMT_SNPRINTF(buffer, size, format, ...) snprintf(buffer, size, format, __VA_ARGS__)
 #endif
 
 #include <stdint.h>
+#include <string.h> //memcpy
 
 namespace LiveMemTracer
 {
-	typedef uint32_t Hash;
+	typedef uint64_t Hash;
+
+	struct Header
+	{
+		Hash      hash;
+		uint64_t  size : 47;
+		uint64_t  heap : 8;
+		uint64_t  tag : 8;
+		uint64_t  aligned : 1;
+#if defined(LMT_HEADER_TIME) || defined(LMT_USE_USABLE_SIZE) || defined(LMT_GENERATION_ACTIVATED)
+		// Keep user pointers 16 bytes aligned
+		uint64_t  time;       // LMT_LIFETIME_ACTIVATED, LMT_LIVE_TABLE_ACTIVATED
+		uint32_t  slack;      // LMT_USE_USABLE_SIZE
+		uint32_t  generation; // LMT_GENERATION_ACTIVATED
+#endif
+	};
+
+	static const size_t HEADER_SIZE = sizeof(Header);
+	static const size_t ALIGNED_HEADER_SIZE = sizeof(size_t) + sizeof(Header);
 
-	LMT_INLINE void *alloc(size_t size);
-	LMT_INLINE void *allocAligned(size_t size, size_t alignment);
-	LMT_INLINE void dealloc(void *ptr);
-	LMT_INLINE void deallocAligned(void *ptr);
-	LMT_INLINE void *realloc(void *ptr, size_t size);
-	LMT_INLINE void *reallocAligned(void *ptr, size_t size, size_t alignment);
+	// Allocator policy used when no heap is specified.
+	// Forward to LMT_USE_MALLOC, LMT_USE_REALLOC and LMT_USE_FREE.
+	// A custom heap have to expose the same interface with
+	// an unique ID lower than LMT_HEAP_NUMBER.
+	struct DefaultHeap
+	{
+		static const uint8_t ID = 0;
+		static const char *name() { return "Default"; }
+		static void *allocate(size_t size);
+		static void *reallocate(void *ptr, size_t size);
+		static void deallocate(void *ptr);
+	};
+
+	template <class Heap = DefaultHeap> LMT_INLINE void *alloc(size_t size);
+	template <class Heap = DefaultHeap> LMT_INLINE void *allocAligned(size_t size, size_t alignment);
+	template <class Heap = DefaultHeap> LMT_INLINE void dealloc(void *ptr);
+	template <class Heap = DefaultHeap> LMT_INLINE void deallocAligned(void *ptr);
+	template <class Heap = DefaultHeap> LMT_INLINE void *realloc(void *ptr, size_t size);
+	template <class Heap = DefaultHeap> LMT_INLINE void *reallocAligned(void *ptr, size_t size, size_t alignment);
+	void *registerAlloc(void *ptr, size_t size, uint8_t heap);
+	void *registerAllocAligned(void *ptr, size_t size, size_t alignment, uint8_t heap);
+	void *unregisterAlloc(void *ptr, uint8_t heap);
+	void *unregisterAllocAligned(void *ptr, uint8_t heap);
+	void registerHeap(uint8_t heap, const char *name);
+
+	// Called after treatChunk released LMT's lock, when a tag exceeded its budget
+	typedef void(*TagBudgetCallback)(const char *tag, size_t budget, size_t allocSize);
+	uint8_t registerTag(const char *name);
+	uint8_t pushTag(uint8_t tag);
+	void popTag(uint8_t previous);
+	void setTagBudget(const char *name, size_t budget);
+	void setTagBudgetCallback(TagBudgetCallback callback);
+
+	// Sub-allocations done by your own pools, they do not have Header,
+	// pointers are matched at treatment time.
+	void poolAlloc(uint8_t pool, void *ptr, size_t size);
+	void poolFree(uint8_t pool, void *ptr);
+	void registerPool(uint8_t pool, const char *name, void *base = nullptr, size_t capacity = 0);
+
+	// Non-heap resources (mapped files, GPU buffers...), tracked like pools
+	// under a root per resource kind. Handle should not be size_t(-1).
+	void trackResource(uint8_t kind, size_t handle, size_t size);
+	void untrackResource(uint8_t kind, size_t handle);
+	void registerResourceKind(uint8_t kind, const char *name);
+
+	// Frames whose symbol starts with prefix, or whose function is in [begin, end[,
+	// are folded. Rules have to be added before the frames are first symbolized.
+	void addFoldPrefix(const char *prefix);
+	void addFoldRange(const void *begin, const void *end);
+
+	// Write the size classes histogram of each stack as CSV,
+	// return false if LMT_SIZE_CLASS_ACTIVATED is not defined or the file can't be opened.
+	bool exportSizeClasses(const char *path);
+
+	// Start a new frame, events are accounted to the frame they are logged in.
+	// Do nothing if LMT_FRAME_ACTIVATED is not defined.
+	void frameMark();
+	void setFrameBudget(size_t bytes);
+
+	// Start a new generation and return it, allocations are attributed to the
+	// generation they are done in. liveSinceMark return the bytes still alive
+	// that were allocated since the generation was started.
+	// Return 0 if LMT_GENERATION_ACTIVATED is not defined.
+	uint32_t mark();
+	size_t liveSinceMark(uint32_t generation);
+
+	// Write every stack still holding memory, biggest first, to path or
+	// to stderr if path is nullptr. Only treated chunks are reported.
+	bool writeLeakReport(const char *path = nullptr);
+
+	// Write every live heap allocation (pointer, size, timestamp and stack)
+	// and the stacks they come from, return false if LMT_LIVE_TABLE_ACTIVATED
+	// is not defined or the file can't be opened.
+	bool dumpHeap(const char *path);
+
+	struct TagScope
+	{
+		TagScope(uint8_t tag) : _previous(pushTag(tag)) {}
+		~TagScope() { popTag(_previous); }
+	private:
+		uint8_t _previous;
+	};
+	LMT_INLINE void *calloc(size_t count, size_t size);
+	LMT_INLINE void *alignedAlloc(size_t alignment, size_t size);
+	LMT_INLINE int posixMemalign(void **memptr, size_t alignment, size_t size);
+	LMT_INLINE size_t usableSize(void *ptr);
 	void exit();
 	void init();
 	void display(float dt);
@@ -163,11 +451,96 @@ namespace LiveMemTracer
 	static const char  *TRUNCATED_STACK_NAME = "Truncated\0";
 	static const char  *UNKNOWN_STACK_NAME = "Unknown\0";
 	static const size_t HISTORY_FRAME_NUMBER = 120;
-	template <class T> LMT_INLINE Hash combineHash(const T& val, const Hash baseHash = 2166136261U);
+	template <class T> LMT_INLINE Hash combineHash(const T& val, const Hash baseHash = 14695981039346656037ULL);
+	LMT_INLINE Hash hashCallstack(void **stack, uint32_t count);
 	static uint32_t getCallstack(uint32_t maxStackSize, void **stack, Hash *hash);
 #endif
 }
 
+template <class Heap>
+void *LiveMemTracer::alloc(size_t size)
+{
+	return registerAlloc(Heap::allocate(size + HEADER_SIZE), size, Heap::ID);
+}
+
+template <class Heap>
+void *LiveMemTracer::allocAligned(size_t size, size_t alignment)
+{
+	if (alignment < 8)
+	{
+		alignment = 8;
+	}
+	return registerAllocAligned(Heap::allocate(size + alignment - 1 + ALIGNED_HEADER_SIZE), size, alignment, Heap::ID);
+}
+
+template <class Heap>
+void *LiveMemTracer::realloc(void *ptr, size_t size)
+{
+	if (ptr == nullptr)
+	{
+		return alloc<Heap>(size);
+	}
+
+	if (size == 0)
+	{
+		dealloc<Heap>(ptr);
+		return alloc<Heap>(0);
+	}
+
+	Header *header = (Header*)((void*)((size_t)ptr - HEADER_SIZE));
+	if (size == header->size)
+	{
+		return ptr;
+	}
+	void *newPtr = Heap::reallocate(unregisterAlloc(ptr, Heap::ID), size + HEADER_SIZE);
+	return registerAlloc(newPtr, size, Heap::ID);
+}
+
+template <class Heap>
+void *LiveMemTracer::reallocAligned(void *ptr, size_t size, size_t alignment)
+{
+	if (ptr == nullptr)
+	{
+		return allocAligned<Heap>(size, alignment);
+	}
+
+	Header oldHeader = *(Header*)((void*)((size_t)ptr - HEADER_SIZE));
+
+	if (size == 0)
+	{
+		deallocAligned<Heap>(ptr);
+		return allocAligned<Heap>(0, alignment);
+	}
+
+	if (size == oldHeader.size)
+	{
+		return ptr;
+	}
+	LMT_ASSERT(oldHeader.aligned == 1, "");
+	void *newPtr = allocAligned<Heap>(size, alignment);
+	if (!newPtr)
+		return nullptr;
+	memcpy(newPtr, ptr, size_t(oldHeader.size < size ? oldHeader.size : size));
+	deallocAligned<Heap>(ptr);
+	return newPtr;
+}
+
+template <class Heap>
+void LiveMemTracer::dealloc(void *ptr)
+{
+	if (ptr == nullptr)
+		return;
+	Heap::deallocate(unregisterAlloc(ptr, Heap::ID));
+}
+
+template <class Heap>
+void LiveMemTracer::deallocAligned(void *ptr)
+{
+	if (ptr == nullptr)
+		return;
+	Heap::deallocate(unregisterAllocAligned(ptr, Heap::ID));
+}
+
 #if defined(LMT_PLATFORM_WINDOWS)
 #include "LiveMemTracer_Windows.hpp"
 #elif defined(LMT_PLATFORM_ORBIS)
@@ -177,6 +550,12 @@ namespace LiveMemTracer
 #ifdef LMT_IMPL
 namespace LiveMemTracer
 {
+#ifdef LMT_x64
+#define LMT_HASH_FROM_PTR(ptr) combineHash(ptr)
+#else
+#define LMT_HASH_FROM_PTR(ptr) Hash(ptr)
+#endif
+
 #define LMT_IS_ALPHA(c) (((c) >= 'A' && (c) <= 'Z') || ((c) >= 'a' && (c) <= 'z'))
 #define LMT_TO_UPPER(c) ((c) & 0xDF)
 
@@ -203,6 +582,12 @@ namespace LiveMemTracer
 		return nullptr;
 	}
 
+	// LMT's own data structures are allocated in pages of a private arena,
+	// they never go through the tracking functions
+	static void *internalAlloc(size_t size);
+	static void internalFree(void *ptr, size_t size);
+
+	// Only used with trivially copyable types.
 	template <typename T>
 	class LMTVector
 	{
@@ -210,7 +595,7 @@ namespace LiveMemTracer
 		LMTVector() : _data(nullptr), _size(0), _capacity(0) {}
 		~LMTVector()
 		{
-			LMT_DEALLOC(_data);
+			internalFree(_data, _capacity * sizeof(T));
 		}
 		LMT_INLINE void push_back(const T &o)
 		{
@@ -228,19 +613,14 @@ namespace LiveMemTracer
 			_data[_size - 1].~T();
 			--_size;
 		}
-		LMT_INLINE void resize(uint16_t size)
+		LMT_INLINE void resize(uint32_t size)
 		{
-			if (size <= _capacity && size >= _size)
-			{
-				_size = size;
-				return;
-			}
 			reserve(size);
 			_size = size;
 		}
 		LMT_INLINE void clear()
 		{
-			for (uint16_t i = 0; i < _size; ++i)
+			for (uint32_t i = 0; i < _size; ++i)
 			{
 				_data[i].~T();
 			}
@@ -274,17 +654,19 @@ namespace LiveMemTracer
 		LMT_INLINE const T *begin() const { return _data; }
 		LMT_INLINE const T *end() const { return _data + _size; }
 	private:
-		LMT_INLINE void reserve(Hash capacity)
+		LMT_INLINE void reserve(uint32_t capacity)
 		{
-			_capacity = capacity;
-			T *newData = (T*)LMT_ALLOC(_capacity * sizeof(T));
+			if (capacity <= _capacity)
+				return;
+			T *newData = (T*)internalAlloc(capacity * sizeof(T));
 			memcpy(newData, _data, _size * sizeof(T));
-			LMT_DEALLOC(_data);
+			internalFree(_data, _capacity * sizeof(T));
 			_data = newData;
+			_capacity = capacity;
 		}
 		T        *_data;
-		uint16_t _size;
-		uint16_t _capacity;
+		uint32_t _size;
+		uint32_t _capacity;
 
 		LMTVector(const LMTVector &o);
 		LMTVector(LMTVector &&o);
@@ -292,16 +674,6 @@ namespace LiveMemTracer
 		LMTVector &operator=(LMTVector &&o);
 	};
 
-	struct Header
-	{
-		Hash      hash;
-		uint64_t  size : 63;
-		uint64_t  aligned : 1;
-	};
-
-	static const size_t HEADER_SIZE = sizeof(Header);
-	static const size_t ALIGNED_HEADER_SIZE = sizeof(size_t) + sizeof(Header);
-
 	enum class ChunkStatus : size_t
 	{
 		TREATED = 0,
@@ -315,6 +687,40 @@ namespace LiveMemTracer
 		Hash                     allocHash[LMT_ALLOC_NUMBER_PER_CHUNK];
 		size_t                   allocStackIndex[LMT_ALLOC_NUMBER_PER_CHUNK];
 		uint8_t                  allocStackSize[LMT_ALLOC_NUMBER_PER_CHUNK];
+		uint8_t                  allocHeap[LMT_ALLOC_NUMBER_PER_CHUNK];
+		uint8_t                  allocTag[LMT_ALLOC_NUMBER_PER_CHUNK];
+		uint8_t                  allocPool[LMT_ALLOC_NUMBER_PER_CHUNK]; // pool + 1, 0 for heap allocations
+		void                     *allocPtr[LMT_ALLOC_NUMBER_PER_CHUNK]; // Pool events, and heap events with LMT_LIVE_TABLE_ACTIVATED
+		uint64_t                 allocTime[LMT_ALLOC_NUMBER_PER_CHUNK]; // Pool events sequence, and heap allocation time with LMT_LIVE_TABLE_ACTIVATED
+#ifdef LMT_CHURN_ACTIVATED
+		// Allocations and frees merged in each event
+		uint32_t                 allocCount[LMT_ALLOC_NUMBER_PER_CHUNK];
+		uint32_t                 freeCount[LMT_ALLOC_NUMBER_PER_CHUNK];
+		size_t                   allocBytes[LMT_ALLOC_NUMBER_PER_CHUNK];
+#endif
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+		// Only allocations of the same size class are merged
+		uint8_t                  allocSizeClass[LMT_ALLOC_NUMBER_PER_CHUNK];
+		uint32_t                 sizeClassCount[LMT_ALLOC_NUMBER_PER_CHUNK];
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+		// Bytes rounded up by the allocator, negative for frees
+		ptrdiff_t                allocSlack[LMT_ALLOC_NUMBER_PER_CHUNK];
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+		// Only events of the same generation are merged
+		uint32_t                 allocGeneration[LMT_ALLOC_NUMBER_PER_CHUNK];
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+		// Only events of the same frame are merged
+		uint32_t                 allocFrame[LMT_ALLOC_NUMBER_PER_CHUNK];
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+		// Only frees of the same lifetime bucket are merged
+		uint8_t                  freeLifetime[LMT_ALLOC_NUMBER_PER_CHUNK];
+		uint32_t                 lifetimeCount[LMT_ALLOC_NUMBER_PER_CHUNK];
+		size_t                   lifetimeBytes[LMT_ALLOC_NUMBER_PER_CHUNK];
+#endif
 		void                     *stackBuffer[LMT_ALLOC_NUMBER_PER_CHUNK * LMT_STACK_SIZE_PER_ALLOC];
 		size_t                   allocIndex;
 		size_t                   stackIndex;
@@ -322,7 +728,94 @@ namespace LiveMemTracer
 		std::atomic<ChunkStatus> status;
 	};
 
-	struct Edge;
+	// Cumulative counters, frees don't cancel allocations
+	struct Churn
+	{
+#ifdef LMT_CHURN_ACTIVATED
+		uint64_t allocCount;
+		uint64_t allocBytes;
+		uint64_t freeCount;
+#endif
+	};
+
+	static LMT_INLINE Churn makeChurn(uint64_t allocCount, uint64_t allocBytes, uint64_t freeCount)
+	{
+		Churn churn;
+#ifdef LMT_CHURN_ACTIVATED
+		churn.allocCount = allocCount;
+		churn.allocBytes = allocBytes;
+		churn.freeCount = freeCount;
+#else
+		(void)allocCount; (void)allocBytes; (void)freeCount;
+#endif
+		return churn;
+	}
+
+#ifdef LMT_CHURN_ACTIVATED
+	static LMT_INLINE void addChurn(Churn &to, const Churn &churn)
+	{
+		to.allocCount += churn.allocCount;
+		to.allocBytes += churn.allocBytes;
+		to.freeCount += churn.freeCount;
+	}
+#endif
+
+	static LMT_INLINE Churn getChurn(const Chunk *chunk, size_t index)
+	{
+#ifdef LMT_CHURN_ACTIVATED
+		return makeChurn(chunk->allocCount[index], chunk->allocBytes[index], chunk->freeCount[index]);
+#else
+		(void)chunk; (void)index;
+		return makeChurn(0, 0, 0);
+#endif
+	}
+
+#if defined(LMT_SIZE_CLASS_ACTIVATED) || defined(LMT_LIFETIME_ACTIVATED)
+	// Floor of log2, 0 for 0
+	static LMT_INLINE uint8_t getLog2(uint64_t value)
+	{
+		uint8_t log = 0;
+		for (uint8_t shift = 32; shift != 0; shift >>= 1)
+		{
+			if (value >> shift)
+			{
+				value >>= shift;
+				log += shift;
+			}
+		}
+		return log;
+	}
+#endif
+
+	// Log2 buckets, class i count allocations of [2^i, 2^(i+1)[ bytes
+	// (0 and 1 byte allocations are in class 0, the last one has no upper bound)
+	static const uint8_t SIZE_CLASS_NUMBER = 32;
+
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+	static LMT_INLINE uint8_t getSizeClass(size_t size)
+	{
+		const uint8_t sizeClass = getLog2(size);
+		return sizeClass < SIZE_CLASS_NUMBER ? sizeClass : SIZE_CLASS_NUMBER - 1;
+	}
+#endif
+
+	// Log2 buckets of LMT_TIMESTAMP ticks, bucket i count frees after
+	// [2^(i+LIFETIME_TICK_SHIFT), 2^(i+LIFETIME_TICK_SHIFT+1)[ ticks
+	static const uint8_t LIFETIME_BUCKET_NUMBER = 32;
+	static const uint8_t LIFETIME_TICK_SHIFT = 10;
+
+#ifdef LMT_LIFETIME_ACTIVATED
+	static LMT_INLINE uint8_t getLifetimeBucket(uint64_t ticks)
+	{
+		const uint8_t bucket = getLog2(ticks >> LIFETIME_TICK_SHIFT);
+		return bucket < LIFETIME_BUCKET_NUMBER ? bucket : LIFETIME_BUCKET_NUMBER - 1;
+	}
+#endif
+
+	// Call tree nodes are addressed by index, node 0 is never used
+	// (it receives the updates when the tree is full)
+	typedef uint32_t EdgeIndex;
+	static const EdgeIndex EDGE_NONE = 0;
 
 	struct Alloc
 	{
@@ -334,64 +827,120 @@ namespace LiveMemTracer
 		const char *str;
 		Alloc *next;
 		Alloc *shared;
-		Edge  *edges;
-		Alloc() : allocSize(0), allocSizeCache(0), str(nullptr), next(nullptr), shared(nullptr), edges(nullptr) {}
+		EdgeIndex edges;
+		bool   folded;
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+		uint32_t sizeClasses[SIZE_CLASS_NUMBER];
+		Alloc() : allocSize(0), allocSizeCache(0), str(nullptr), next(nullptr), shared(nullptr), edges(EDGE_NONE), folded(false), sizeClasses() {}
+#else
+		Alloc() : allocSize(0), allocSizeCache(0), str(nullptr), next(nullptr), shared(nullptr), edges(EDGE_NONE), folded(false) {}
+#endif
 	};
 
 	struct AllocStack
 	{
 		ptrdiff_t allocSize;
-		LMTVector<Alloc*> stackAllocs;
+		uint32_t stackOffset; // Frames position in the stack arena
+#ifdef LMT_STACK_VERIFY
+		LMTVector<void*> frames;
+#endif
+#ifdef LMT_COLLAPSE_RECURSION
+		LMTVector<uint8_t> recursions;
+#endif
+#ifdef LMT_CHURN_ACTIVATED
+		Churn churn;
+		Churn churnCache;
+		float allocRate;
+		float bytesRate;
+		float freeRate;
+#endif
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+		uint32_t sizeClasses[SIZE_CLASS_NUMBER];
+#endif
+#ifdef LMT_INSTANCE_COUNT_ACTIVATED
+		ptrdiff_t instanceCount;
+#endif
+#ifdef LMT_PEAK_ACTIVATED
+		ptrdiff_t peakSize;
+		bool      pooled; // Pool and resource stacks are not part of the heap peak
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+		ptrdiff_t slackSize;
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+		// Ring of the last LMT_GENERATION_NUMBER generations,
+		// older ones are merged in oldGenerationSize
+		ptrdiff_t generationSizes[LMT_GENERATION_NUMBER];
+		uint32_t  generations[LMT_GENERATION_NUMBER];
+		ptrdiff_t oldGenerationSize;
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+		uint32_t lifetimes[LIFETIME_BUCKET_NUMBER];
+		uint64_t lifetimeBytes[LIFETIME_BUCKET_NUMBER];
+#endif
+		AllocStack *next;
 		Hash hash;
 		uint8_t stackSize;
-		AllocStack() : hash(0), allocSize(0), stackSize(0) {}
+		// Arrays are zeroed with the dictionary memory
+		AllocStack() : allocSize(0), stackOffset(0), next(nullptr), hash(0), stackSize(0) {}
 	};
 
+	// Cold part of a call tree node, counters updated at each event
+	// are in g_edgeSizes and g_edgeInstanceCounts
 	struct Edge
 	{
-		ptrdiff_t allocSize;
 		ptrdiff_t allocSizeCache;
 #ifdef LMT_CAPTURE_ACTIVATED
 		ptrdiff_t allocSizeCapture;
-#endif
-#ifdef LMT_INSTANCE_COUNT_ACTIVATED
-		ptrdiff_t instanceCount;
 #endif
 		Alloc *alloc;
-		LMTVector<Edge*> to;
-		Edge *from;
-		Edge *same;
+		EdgeIndex from;
+		EdgeIndex firstChild;
+		EdgeIndex nextSibling;
+		EdgeIndex same;
 		uint8_t depth;
-		Edge() : allocSize(0), alloc(nullptr), from(nullptr), same(nullptr)
-		{
-#ifdef LMT_CAPTURE_ACTIVATED
-			allocSizeCapture = 0;
-#endif
-#ifdef LMT_INSTANCE_COUNT_ACTIVATED
-			instanceCount = 0;
+#ifdef LMT_COLLAPSE_RECURSION
+		uint8_t recursion;
 #endif
-		}
 	};
 
+	// Returns zeroed memory, physical pages are only used once touched
+	static void *reserveMemory(size_t size)
+	{
+#if defined(LMT_RESERVE_MEMORY)
+		void *ptr = LMT_RESERVE_MEMORY(size);
+#elif defined(LMT_PLATFORM_WINDOWS)
+		// Committed pages are only backed by physical memory once touched
+		void *ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+		void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (ptr == MAP_FAILED)
+			ptr = nullptr;
+#endif
+		LMT_ASSERT(ptr != nullptr, "LMT : Cannot reserve memory.");
+		return ptr;
+	}
+
+	// Buckets are in reserved memory and are never constructed,
+	// a zeroed Value has to be a valid empty value.
 	template <typename Key, typename Value, Hash Capacity>
 	class Dictionary
 	{
 	public:
-		static const size_t   HASH_EMPTY = Hash(-1);
-		static const size_t   HASH_INVALID = Hash(-2);
+		static const Hash     HASH_INVALID = Hash(-1);
 
 		Dictionary(const char *name)
 			:_name(name)
 		{
+			_buffer = (Pair*)reserveMemory(RESERVED_SIZE);
 		}
 
 		class Pair
 		{
 		private:
-			Hash  _hash;
+			bool  _used;
 			Key   _key;
 			Value _value;
-			Pair() : _hash(HASH_EMPTY) {}
 		public:
 			LMT_INLINE Value &getValue() { return _value; }
 			friend class Dictionary;
@@ -407,12 +956,12 @@ namespace LiveMemTracer
 			}
 
 			Pair *pair = &_buffer[hash];
-			if (pair->_hash == HASH_EMPTY)
+			if (!pair->_used)
 			{
-				pair->_hash = hash;
+				pair->_used = true;
 				pair->_key = key;
 #ifdef LMT_STATS
-				_size.fetch_add(1);
+				_size.store(_size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 #endif
 			}
 			return pair;
@@ -421,22 +970,31 @@ namespace LiveMemTracer
 #ifdef LMT_STATS
 		LMT_INLINE float getHitStats() const
 		{
-			return _hitTotal.load() / float(_hitCount.load());
+			return _hitTotal.load(std::memory_order_relaxed) / float(_hitCount.load(std::memory_order_relaxed));
 		}
 
 		LMT_INLINE float getRatio() const
 		{
-			size_t size = _size;
+			size_t size = _size.load(std::memory_order_relaxed);
 			return size / float(Capacity) * 100.f;
 		}
 #endif
+		static const size_t RESERVED_SIZE = sizeof(Pair) * Capacity;
 	private:
-		Pair _buffer[Capacity];
+		Pair *_buffer;
 		const char *_name;
 #ifdef LMT_STATS
+		// Only written with LMT's lock held (treatChunk, and the renderer views
+		// called by Renderer::render), no need for atomic increments
 		mutable std::atomic_size_t _hitCount;
 		mutable std::atomic_size_t _hitTotal;
 		mutable std::atomic_size_t _size;
+
+		LMT_INLINE void addHits(size_t hits) const
+		{
+			_hitCount.store(_hitCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			_hitTotal.store(_hitTotal.load(std::memory_order_relaxed) + hits, std::memory_order_relaxed);
+		}
 #endif
 
 		LMT_INLINE Hash getHash(const Key &key) const
@@ -444,54 +1002,173 @@ namespace LiveMemTracer
 			for (Hash i = 0; i < Capacity; ++i)
 			{
 				const Hash realHash = (key + i) % Capacity;
-				if (_buffer[realHash]._hash == HASH_EMPTY || _buffer[realHash]._key == key)
+				if (!_buffer[realHash]._used || _buffer[realHash]._key == key)
 				{
 #ifdef LMT_STATS
-					_hitCount += 1;
-					_hitTotal += i;
+					addHits(i);
 #endif
 					return realHash;
 				}
 			}
 #ifdef LMT_STATS
-			_hitTotal += Capacity - 1;
+			addHits(Capacity - 1);
 #endif
 			LMT_DEBUG_ASSERT(false, "LMT : Dictionary %s is full.", _name);
 			return HASH_INVALID;
 		}
 	};
 
-	enum RunningStatus : unsigned char
+	// Open addressing table of the live pool allocations (and heap allocations
+	// with LMT_LIVE_TABLE_ACTIVATED), only accessed from treatChunk and the renderer (g_mutex).
+	// Entries are in reserved memory.
+	template <size_t Capacity>
+	class LiveTable
 	{
-		NOT_INITIALIZED,
-		RUNNING,
-		EXIT
-	};
-
-	LMT_TLS static Chunk                     *g_th_currentChunk = nullptr;
-	LMT_TLS static Chunk                     g_th_chunks[LMT_CHUNK_NUMBER_PER_THREAD];
-	LMT_TLS static uint8_t                   g_th_chunkIndex = 0;
-	LMT_TLS static Hash                      g_th_cache[LMT_CACHE_SIZE];
-	LMT_TLS static uint8_t                   g_th_cacheIndex = 0;
-	LMT_TLS static bool                      g_th_initialized = false;
-	LMT_TLS static uint8_t                   g_th_lmt_internal_scope = 0;
-
-
-	static Alloc                             *g_allocList = nullptr;
+	public:
+		struct Entry
+		{
+			void      *ptr;
+			size_t     size;
+			Hash       stack;
+			uint64_t   time;
+			uint8_t    pool;
+			bool       freed; // Free treated before its allocation
+		};
 
-	struct TreeKey
-	{
-		TreeKey()
-			: hash(0), str(0){}
+		static const size_t RESERVED_SIZE = sizeof(Entry) * Capacity;
+		// Above this load new entries are dropped, probing stays short
+		// and remove always finds an empty slot
+		static const size_t MAX_SIZE = Capacity / 8 * 7;
+		static_assert(MAX_SIZE > 0 && MAX_SIZE < Capacity, "Live table capacity is too small");
 
-		TreeKey(Hash _hash, Hash _str)
-			: hash(_hash), str(_str)
+		LiveTable(const char *name)
+			: _name(name), _size(0), _dropped(0)
 		{
+			_buffer = (Entry*)reserveMemory(RESERVED_SIZE);
 		}
-		TreeKey& operator=(const TreeKey &o)
+
+		Entry *find(void *ptr, uint8_t pool)
 		{
-			this->hash = o.hash;
-			this->str = o.str;
+			for (size_t i = 0, h = index(ptr, pool); i < Capacity; ++i, h = (h + 1) % Capacity)
+			{
+				Entry &e = _buffer[h];
+				if (e.ptr == nullptr)
+					return nullptr;
+				if (e.ptr == ptr && e.pool == pool)
+					return &e;
+			}
+			return nullptr;
+		}
+
+		Entry *insert(void *ptr, uint8_t pool)
+		{
+			for (size_t i = 0, h = index(ptr, pool); i < Capacity; ++i, h = (h + 1) % Capacity)
+			{
+				Entry &e = _buffer[h];
+				if (e.ptr == nullptr)
+				{
+					if (_size >= MAX_SIZE)
+					{
+						++_dropped;
+						return nullptr;
+					}
+					// Removed entries keep their old values
+					e = Entry();
+					e.ptr = ptr;
+					e.pool = pool;
+					++_size;
+					return &e;
+				}
+				if (e.ptr == ptr && e.pool == pool)
+					return &e;
+			}
+			LMT_DEBUG_ASSERT(false, "LMT : Live table %s is full.", _name);
+			return nullptr;
+		}
+
+		// Backward shift deletion, no tombstone
+		void remove(Entry *entry)
+		{
+			size_t hole = size_t(entry - _buffer);
+			size_t h = (hole + 1) % Capacity;
+			for (size_t i = 0; i < Capacity && _buffer[h].ptr != nullptr; ++i)
+			{
+				const size_t ideal = index(_buffer[h].ptr, _buffer[h].pool);
+				if ((h > hole && (ideal <= hole || ideal > h)) || (h < hole && (ideal <= hole && ideal > h)))
+				{
+					_buffer[hole] = _buffer[h];
+					hole = h;
+				}
+				h = (h + 1) % Capacity;
+			}
+			_buffer[hole].ptr = nullptr;
+			--_size;
+		}
+
+		LMT_INLINE Entry *begin() { return _buffer; }
+		LMT_INLINE Entry *end() { return _buffer + Capacity; }
+		LMT_INLINE size_t size() const { return _size; }
+		// Entries refused because the table was too full
+		LMT_INLINE size_t dropped() const { return _dropped; }
+		LMT_INLINE float getRatio() const { return _size / float(Capacity) * 100.f; }
+	private:
+		LMT_INLINE size_t index(void *ptr, uint8_t pool) const
+		{
+			return size_t(combineHash(pool, LMT_HASH_FROM_PTR(ptr))) % Capacity;
+		}
+
+		Entry      *_buffer;
+		const char *_name;
+		size_t      _size;
+		size_t      _dropped;
+	};
+
+	enum RunningStatus : unsigned char
+	{
+		NOT_INITIALIZED,
+		RUNNING,
+		EXIT
+	};
+
+	LMT_TLS static Chunk                     *g_th_currentChunk = nullptr;
+	LMT_TLS static Chunk                     g_th_chunks[LMT_CHUNK_NUMBER_PER_THREAD];
+	LMT_TLS static uint8_t                   g_th_chunkIndex = 0;
+	LMT_TLS static Hash                      g_th_cache[LMT_CACHE_SIZE];
+	LMT_TLS static uint8_t                   g_th_cacheIndex = 0;
+	LMT_TLS static bool                      g_th_initialized = false;
+	LMT_TLS static uint8_t                   g_th_lmt_internal_scope = 0;
+	LMT_TLS static uint8_t                   g_th_currentTag = 0;
+
+	// Internal arena, blocks are sized by power of two from INTERNAL_MIN_BLOCK,
+	// bigger blocks than INTERNAL_MAX_BLOCK are directly allocated with LMT_USE_MALLOC
+	struct InternalBlock
+	{
+		InternalBlock *next;
+	};
+	static const size_t                       INTERNAL_MIN_BLOCK = 16;
+	static const size_t                       INTERNAL_MAX_BLOCK = (LMT_INTERNAL_PAGE_SIZE) / 4;
+	static const size_t                       INTERNAL_CLASS_NUMBER = 32;
+	static InternalBlock                     *g_internalFreeLists[INTERNAL_CLASS_NUMBER];
+	static char                              *g_internalPageCursor = nullptr;
+	static char                              *g_internalPageEnd = nullptr;
+	static std::mutex                         g_internalMutex;
+
+
+	static Alloc                             *g_allocList = nullptr;
+
+	struct TreeKey
+	{
+		TreeKey()
+			: hash(0), str(0){}
+
+		TreeKey(Hash _hash, Hash _str)
+			: hash(_hash), str(_str)
+		{
+		}
+		TreeKey& operator=(const TreeKey &o)
+		{
+			this->hash = o.hash;
+			this->str = o.str;
 			return *this;
 		}
 		bool operator==(const TreeKey &o) const
@@ -506,17 +1183,148 @@ namespace LiveMemTracer
 
 	static Dictionary<Hash, AllocStack, LMT_STACK_DICTIONARY_SIZE>    g_stackDictionary("STACK_DICTIONARY");
 	static Dictionary<Hash, Alloc, LMT_ALLOC_DICTIONARY_SIZE>         g_allocDictionary("ALLOC_DICTIONARY");
-	static Dictionary<TreeKey, Edge, LMT_TREE_DICTIONARY_SIZE>        g_treeDictionary("TREE_DICTIONARY");
+	static Dictionary<TreeKey, EdgeIndex, LMT_TREE_DICTIONARY_SIZE>   g_treeDictionary("TREE_DICTIONARY");
 
 #ifdef LMT_STATS
-	static std::atomic_size_t                                   g_userAllocations;
-	static std::atomic_size_t                                   g_realUserAllocations;
+	// User allocations counters are spread over cache line sized slots,
+	// each thread writes in its own slot and readers sum them
+	// (alignas is not supported by Visual Studio 2013)
+	struct LMT_ALIGN(64) StatsSlot
+	{
+		std::atomic<ptrdiff_t> userAllocations;
+		std::atomic<ptrdiff_t> realUserAllocations;
+	};
+	static_assert(sizeof(StatsSlot) == 64, "StatsSlot should fill exactly one cache line");
+	static StatsSlot                                            g_statsSlots[LMT_STATS_SLOT_NUMBER];
+	static std::atomic<uint32_t>                                g_statsSlotCounter = LMT_ATOMIC_INITIALIZER(0);
+	LMT_TLS static StatsSlot                                   *g_th_statsSlot = nullptr;
 	static std::atomic_size_t                                   g_internalAllocations;
 #endif
 
-	static LMTVector<Edge*>                                     g_allocStackRoots;
+	// Frames of all the stacks, appended in chunks that are never released
+	static const uint32_t                                       STACK_ARENA_CHUNK_NUMBER = 1024;
+	static_assert(LMT_STACK_ARENA_CHUNK_SIZE > LMT_STACK_SIZE_PER_ALLOC, "LMT_STACK_ARENA_CHUNK_SIZE should be greater than LMT_STACK_SIZE_PER_ALLOC");
+	static Alloc                                              **g_stackArenaChunks[STACK_ARENA_CHUNK_NUMBER];
+	static uint32_t                                             g_stackArenaChunkCount = 0;
+	static uint32_t                                             g_stackArenaUsed = 0;
+
+	static Edge                                                 g_edges[LMT_TREE_DICTIONARY_SIZE + 1];
+	static ptrdiff_t                                            g_edgeSizes[LMT_TREE_DICTIONARY_SIZE + 1];
+#ifdef LMT_INSTANCE_COUNT_ACTIVATED
+	static ptrdiff_t                                            g_edgeInstanceCounts[LMT_TREE_DICTIONARY_SIZE + 1];
+#endif
+#ifdef LMT_CHURN_ACTIVATED
+	static Churn                                                g_edgeChurns[LMT_TREE_DICTIONARY_SIZE + 1];
+#endif
+	static EdgeIndex                                            g_edgeCount = 1;
+	static size_t                                               g_truncatedTreeStacks = 0; // Stack events cut because the tree was full
+	static AllocStack                                          *g_allocStackList = nullptr;
+	static EdgeIndex                                            g_firstRoot = EDGE_NONE;
+#ifdef LMT_STACK_VERIFY
+	static size_t                                               g_stackCollisions = 0;
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+	static ptrdiff_t                                            g_slackSize = 0;
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+	static std::atomic<uint32_t>                                g_generation = LMT_ATOMIC_INITIALIZER(0);
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+	struct FrameStack
+	{
+		AllocStack *stack;
+		uint64_t    allocBytes;
+	};
+
+	// Aggregates of a frame, in a ring of LMT_FRAME_HISTORY frames.
+	// Top stacks are approximate, a new stack replace the smallest one.
+	struct Frame
+	{
+		uint32_t    index;
+		uint32_t    allocCount;
+		uint32_t    freeCount;
+		uint64_t    allocBytes;
+		FrameStack  stacks[LMT_FRAME_TOP_STACKS];
+	};
+
+	static std::atomic<uint32_t>                                g_frameIndex = LMT_ATOMIC_INITIALIZER(0);
+	static Frame                                                g_frames[LMT_FRAME_HISTORY];
+	static size_t                                               g_frameBudget = 0;
+#endif
+#ifdef LMT_PEAK_ACTIVATED
+	struct PeakEntry
+	{
+		AllocStack *stack;
+		ptrdiff_t   allocSize;
+	};
+
+	// Biggest heap stacks when the peak was last exceeded by LMT_PEAK_SNAPSHOT_MARGIN
+	// (or by an eighth of the snapshot when it's bigger)
+	struct PeakSnapshot
+	{
+		ptrdiff_t   allocSize;
+		size_t      count;
+		PeakEntry   entries[LMT_PEAK_SNAPSHOT_SIZE];
+	};
+
+	static ptrdiff_t                                            g_liveSize = 0;
+	static ptrdiff_t                                            g_peakSize = 0;
+	static PeakSnapshot                                         g_peakSnapshot;
+#endif
+
+	struct Pool
+	{
+		const char *name;
+		void       *base;
+		size_t      capacity;
+		ptrdiff_t   allocSize;
+		ptrdiff_t   peakSize;
+		ptrdiff_t   count;
+		Alloc      *root;
+		Alloc       rootAlloc; // Not in g_allocDictionary, it can't collide with a frame
+		char        rootName[64];
+	};
+
+	// Resource kinds are stored after the pools
+	static Pool                                                 g_pools[LMT_POOL_NUMBER + LMT_RESOURCE_KIND_NUMBER];
+	static_assert(LMT_POOL_NUMBER + LMT_RESOURCE_KIND_NUMBER < 255, "LMT_POOL_NUMBER + LMT_RESOURCE_KIND_NUMBER should be lower than 255");
+	static LiveTable<LMT_POOL_TABLE_SIZE>                       g_poolTable("POOL_TABLE");
+	static std::atomic<uint64_t>                                g_poolSequence = LMT_ATOMIC_INITIALIZER(1); // Orders pool events of different threads
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+	static LiveTable<LMT_LIVE_TABLE_SIZE>                       g_liveTable("LIVE_TABLE");
+	static size_t                                               g_liveFreedCount = 0; // Frees waiting for their allocation
+#endif
+	static ptrdiff_t                                            g_heapAllocSize[LMT_HEAP_NUMBER];
+	static const char                                          *g_heapNames[LMT_HEAP_NUMBER] = { DefaultHeap::name() };
+	static ptrdiff_t                                            g_tagAllocSize[LMT_TAG_NUMBER];
+	static size_t                                               g_tagBudgets[LMT_TAG_NUMBER];
+	static bool                                                 g_tagOverBudget[LMT_TAG_NUMBER];
+	static const char                                          *g_tagNames[LMT_TAG_NUMBER] = { "Untagged" };
+	static std::atomic<uint16_t>                                g_tagCounter = LMT_ATOMIC_INITIALIZER(1);
+	static_assert(LMT_TAG_NUMBER <= 256, "LMT_TAG_NUMBER should be lower or equal to 256, tags are stored on 8 bits");
+	static std::mutex                                           g_tagMutex;
+	static TagBudgetCallback                                    g_tagBudgetCallback = nullptr;
+
+	// Tag going over its budget while a chunk is treated
+	struct TagBudgetCrossing
+	{
+		uint8_t tag;
+		size_t  budget;
+		size_t  allocSize;
+	};
 	static std::mutex                                           g_mutex;
 
+	struct FoldRule
+	{
+		const char *prefix;
+		size_t      prefixLength;
+		uintptr_t   begin;
+		uintptr_t   end;
+	};
+
+	static FoldRule                                             g_foldRules[LMT_FOLD_RULE_NUMBER];
+	static uint8_t                                              g_foldRuleCount = 0;
+
 	static std::atomic<RunningStatus>                           g_runningStatus = LMT_ATOMIC_INITIALIZER(RunningStatus::NOT_INITIALIZED);
 	static std::atomic_size_t                                   g_temporaryChunkCounter = LMT_ATOMIC_INITIALIZER(0);
 
@@ -527,20 +1335,78 @@ namespace LiveMemTracer
 		+ sizeof(g_th_cache)
 		+ sizeof(g_th_cacheIndex)
 		+ sizeof(g_th_initialized)
-		+ sizeof(g_th_lmt_internal_scope);
+		+ sizeof(g_th_lmt_internal_scope)
+#ifdef LMT_STATS
+		+ sizeof(g_th_statsSlot)
+#endif
+		+ sizeof(g_th_currentTag);
 
 	static const size_t                                         g_internalSharedMemoryUsed =
-		sizeof(g_stackDictionary)
-		+ sizeof(g_allocDictionary)
-		+ sizeof(g_treeDictionary)
+		sizeof(g_stackDictionary) + g_stackDictionary.RESERVED_SIZE
+		+ sizeof(g_allocDictionary) + g_allocDictionary.RESERVED_SIZE
+		+ sizeof(g_treeDictionary) + g_treeDictionary.RESERVED_SIZE
 #ifdef LMT_STATS
-		+ sizeof(g_userAllocations)
-		+ sizeof(g_realUserAllocations)
+		+ sizeof(g_statsSlots)
+		+ sizeof(g_statsSlotCounter)
 		+ sizeof(g_internalAllocations)
 #endif
 		+ sizeof(g_allocList)
-		+ sizeof(g_allocStackRoots)
+		+ sizeof(g_stackArenaChunks)
+		+ sizeof(g_stackArenaChunkCount)
+		+ sizeof(g_stackArenaUsed)
+		+ sizeof(g_edges)
+		+ sizeof(g_edgeSizes)
+#ifdef LMT_INSTANCE_COUNT_ACTIVATED
+		+ sizeof(g_edgeInstanceCounts)
+#endif
+#ifdef LMT_CHURN_ACTIVATED
+		+ sizeof(g_edgeChurns)
+#endif
+		+ sizeof(g_edgeCount)
+		+ sizeof(g_truncatedTreeStacks)
+		+ sizeof(g_allocStackList)
+		+ sizeof(g_firstRoot)
+#ifdef LMT_STACK_VERIFY
+		+ sizeof(g_stackCollisions)
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+		+ sizeof(g_slackSize)
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+		+ sizeof(g_generation)
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+		+ sizeof(g_frameIndex)
+		+ sizeof(g_frames)
+		+ sizeof(g_frameBudget)
+#endif
+#ifdef LMT_PEAK_ACTIVATED
+		+ sizeof(g_liveSize)
+		+ sizeof(g_peakSize)
+		+ sizeof(g_peakSnapshot)
+#endif
+		+ sizeof(g_pools)
+		+ sizeof(g_poolTable) + g_poolTable.RESERVED_SIZE
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+		+ sizeof(g_liveTable) + g_liveTable.RESERVED_SIZE
+		+ sizeof(g_liveFreedCount)
+#endif
+		+ sizeof(g_heapAllocSize)
+		+ sizeof(g_heapNames)
+		+ sizeof(g_tagAllocSize)
+		+ sizeof(g_tagBudgets)
+		+ sizeof(g_tagOverBudget)
+		+ sizeof(g_tagNames)
+		+ sizeof(g_tagCounter)
+		+ sizeof(g_tagMutex)
+		+ sizeof(g_tagBudgetCallback)
 		+ sizeof(g_mutex)
+		+ sizeof(g_internalFreeLists)
+		+ sizeof(g_internalPageCursor)
+		+ sizeof(g_internalPageEnd)
+		+ sizeof(g_internalMutex)
+		+ sizeof(g_foldRules)
+		+ sizeof(g_foldRuleCount)
 		+ sizeof(g_internalPerThreadMemoryUsed)
 		+ sizeof(g_runningStatus)
 		+ sizeof(g_temporaryChunkCounter)
@@ -553,13 +1419,13 @@ namespace LiveMemTracer
 		struct Histogram
 		{
 			Alloc *function;
-			Edge  *call;
+			EdgeIndex call;
 			const char *name;
 			bool  isFunction;
 			ptrdiff_t allocSize[HISTORY_FRAME_NUMBER];
 			int  cursor;
 			ptrdiff_t allocSizeCache;
-			Histogram() : function(nullptr), call(nullptr), name(nullptr), isFunction(false), cursor(0), allocSizeCache(0)
+			Histogram() : function(nullptr), call(EDGE_NONE), name(nullptr), isFunction(false), cursor(0), allocSizeCache(0)
 			{
 				memset(allocSize, 0, sizeof(allocSize));
 			}
@@ -571,6 +1437,30 @@ namespace LiveMemTracer
 			FUNCTION,
 			STACK,
 			HISTOGRAMS,
+			HEAPS,
+			TAGS,
+			POOLS,
+#ifdef LMT_CHURN_ACTIVATED
+			CHURN,
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+			LIFETIMES,
+#endif
+#ifdef LMT_PEAK_ACTIVATED
+			PEAK,
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+			FRAMES,
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+			WASTE,
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+			SINCE_MARK,
+#endif
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+			LIVE,
+#endif
 			END
 		};
 
@@ -579,7 +1469,31 @@ namespace LiveMemTracer
 			"Callee",
 			"Function",
 			"Stack",
-			"Histograms"
+			"Histograms",
+			"Heaps",
+			"Tags",
+			"Pools / Resources",
+#ifdef LMT_CHURN_ACTIVATED
+			"Churn",
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+			"Short lived",
+#endif
+#ifdef LMT_PEAK_ACTIVATED
+			"Peak",
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+			"Frames",
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+			"Waste",
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+			"Since mark",
+#endif
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+			"Live allocations",
+#endif
 		};
 
 		enum UpdateType : uint8_t
@@ -606,22 +1520,86 @@ namespace LiveMemTracer
 		static Alloc                              *g_searchResult;
 		static Alloc                              *g_functionView;
 		static LMTVector<GroupedEdge>              g_groupedEdges;
-		static LMTVector<Edge*>                    g_sortedEdges;
+		static LMTVector<EdgeIndex>                g_sortedEdges;
+		struct PoolBlock
+		{
+			size_t  begin;
+			size_t  end;
+			uint8_t pool;
+		};
+
+		static LMTVector<PoolBlock>                g_poolBlocks;
+		// Computed on demand, the pool table is scanned and sorted
+		static float                               g_poolFragmentation[LMT_POOL_NUMBER + LMT_RESOURCE_KIND_NUMBER];
+		static bool                                g_poolFragmentationComputed = false;
+#ifdef LMT_CHURN_ACTIVATED
+		static LMTVector<AllocStack*>              g_churnStacks;
+		static float                               g_churnElapsed = 0.f;
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+		static uint32_t                            g_frameSelected = uint32_t(-1);
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+		static LMTVector<AllocStack*>              g_wasteStacks;
+#endif
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+		static char                                g_liveAddressStr[32];
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+		static LMTVector<AllocStack*>              g_sinceMarkStacks;
+		static int                                 g_sinceMarkGeneration = 0;
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+		static LMTVector<AllocStack*>              g_lifetimeStacks;
+		static int                                 g_lifetimeMaxBucket = 10;
+		static uint64_t                            g_lifetimeStartTicks = 0;
+		static std::chrono::steady_clock::time_point g_lifetimeStartTime;
+		static double                              g_ticksPerSecond = 0.0;
+#endif
 
 		bool searchAlloc();
-		void renderCallee(Edge *callee, bool callerTooltip);
+		void renderCallee(EdgeIndex callee, bool callerTooltip);
 		void renderCallees();
 		void renderFunctionView();
 		void renderMenu();
 		void renderHistograms();
+		void renderHeaps();
+		void renderTags();
+		void renderPools();
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+		void renderSizeClasses(const uint32_t *sizeClasses);
+#endif
+#ifdef LMT_CHURN_ACTIVATED
+		void updateChurnRates();
+		void renderChurn();
+#endif
+#ifdef LMT_PEAK_ACTIVATED
+		void renderPeak();
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+		void renderFrames();
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+		void renderWaste();
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+		void renderSinceMark();
+#endif
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+		void renderLive();
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+		void updateTicksPerSecond();
+		void formatTicks(uint64_t ticks, char *str, size_t length);
+		void renderLifetimes();
+#endif
 		void renderStack();
-		void recursiveCacheData(Edge *edge);
 		void cacheData();
 #ifdef LMT_CAPTURE_ACTIVATED
 		void capture();
 #endif
 		void createHistogram(Alloc *function);
-		void createHistogram(Edge  *functionCall);
+		void createHistogram(EdgeIndex functionCall);
 		void render(float dt);
 	}
 
@@ -629,10 +1607,51 @@ namespace LiveMemTracer
 	static Chunk *createTemporaryChunk();
 	static Chunk *createPreallocatedChunk(const RunningStatus status);
 	static uint8_t findInCache(Hash hash);
-	static void logAllocInChunk(Header *header, size_t size);
+	static void logAllocInChunk(Header *header, size_t size, uint8_t heap, uint8_t tag);
 	static void logFreeInChunk(Header *header);
+	static void addTagBudgetCrossing(TagBudgetCrossing *crossings, size_t &count, uint8_t tag);
 	static void treatChunk(Chunk *chunk);
-	static void updateTree(AllocStack &alloc, ptrdiff_t size, bool checkTree);
+	static void treatPoolEvent(Chunk *chunk, size_t index);
+	static LMT_INLINE bool isEmptyEvent(const Chunk *chunk, size_t index);
+#ifdef LMT_LEAK_REPORT
+	static void flushCurrentChunk();
+#endif
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+	static void treatLiveEvent(const Chunk *chunk, size_t index);
+	static bool writeHeapDump(const char *path);
+#endif
+	static AllocStack &updateStack(const Chunk *chunk, size_t index, Hash hash, ptrdiff_t size, const Churn &churn, Alloc *root);
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+	static void addSizeClass(AllocStack &allocStack, uint8_t sizeClass, uint32_t count);
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+	static void addLifetime(AllocStack &allocStack, uint8_t bucket, uint32_t count, size_t bytes);
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+	static void updateFrame(uint32_t frameIndex, AllocStack &allocStack, const Churn &churn);
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+	static void addGeneration(AllocStack &allocStack, uint32_t generation, ptrdiff_t size);
+	static ptrdiff_t getSizeSinceMark(const AllocStack &allocStack, uint32_t generation);
+#endif
+#ifdef LMT_PEAK_ACTIVATED
+	static void updatePeak(ptrdiff_t size);
+	static void takePeakSnapshot();
+	static void resetPeak();
+#endif
+	static uint32_t allocateStackFrames(uint32_t count);
+	static LMT_INLINE Alloc **getStackAllocs(const AllocStack &allocStack);
+	static bool isFolded(const char *name, void *address);
+	static uint8_t foldStack(AllocStack &allocStack, uint8_t stackSize, ptrdiff_t size);
+#ifdef LMT_COLLAPSE_RECURSION
+	static uint8_t collapseRecursion(AllocStack &allocStack, uint8_t stackSize, ptrdiff_t size);
+#endif
+	static Alloc *getPoolRoot(uint8_t pool);
+	static FILE *openFile(const char *path);
+	static void logPoolAllocInChunk(uint8_t pool, void *ptr, size_t size);
+	static void logPoolFreeInChunk(uint8_t pool, void *ptr);
+	static void updateTree(AllocStack &alloc, ptrdiff_t size, const Churn &churn, bool checkTree);
+	static EdgeIndex createEdge();
 }
 #endif
 
@@ -641,13 +1660,87 @@ namespace LiveMemTracer
 {
 #define GET_HEADER(ptr) (Header*)((void*)((size_t)ptr - HEADER_SIZE))
 #define GET_ALIGNED_PTR(ptr) (void*)(*(size_t*)((void*)(size_t(ptr) - ALIGNED_HEADER_SIZE)))
-#define GET_ALIGNED_SIZE(size, alignment) size + --alignment + ALIGNED_HEADER_SIZE
 #ifdef LMT_STATS
-#define LOG_REAL_SIZE_ALLOC(header, ptr) g_realUserAllocations.fetch_add(size_t(uint64_t(ptr) - uint64_t(header) + header->size)); g_userAllocations.fetch_add(header->size)
-#define LOG_REAL_SIZE_FREE(header, ptr)  g_realUserAllocations.fetch_sub(size_t(uint64_t(ptr) - uint64_t(header) + header->size)); g_userAllocations.fetch_sub(header->size)
+	static LMT_INLINE StatsSlot *getStatsSlot()
+	{
+		if (g_th_statsSlot == nullptr)
+			g_th_statsSlot = &g_statsSlots[g_statsSlotCounter.fetch_add(1) % LMT_STATS_SLOT_NUMBER];
+		return g_th_statsSlot;
+	}
+
+	static LMT_INLINE void logRealSize(ptrdiff_t realSize, ptrdiff_t size)
+	{
+		StatsSlot *slot = getStatsSlot();
+		slot->realUserAllocations.fetch_add(realSize, std::memory_order_relaxed);
+		slot->userAllocations.fetch_add(size, std::memory_order_relaxed);
+	}
+
+	static ptrdiff_t sumStatsSlots(std::atomic<ptrdiff_t> StatsSlot::*counter)
+	{
+		ptrdiff_t sum = 0;
+		for (size_t i = 0; i < LMT_STATS_SLOT_NUMBER; ++i)
+			sum += (g_statsSlots[i].*counter).load(std::memory_order_relaxed);
+		return sum;
+	}
+#ifdef LMT_USE_USABLE_SIZE
+#define LOG_REAL_SIZE_ALLOC(header, ptr) logRealSize(ptrdiff_t(uint64_t(ptr) - uint64_t(header) + header->size + header->slack), ptrdiff_t(header->size))
+#define LOG_REAL_SIZE_FREE(header, ptr)  logRealSize(-ptrdiff_t(uint64_t(ptr) - uint64_t(header) + header->size + header->slack), -ptrdiff_t(header->size))
+#else
+#define LOG_REAL_SIZE_ALLOC(header, ptr) logRealSize(ptrdiff_t(uint64_t(ptr) - uint64_t(header) + header->size), ptrdiff_t(header->size))
+#define LOG_REAL_SIZE_FREE(header, ptr)  logRealSize(-ptrdiff_t(uint64_t(ptr) - uint64_t(header) + header->size), -ptrdiff_t(header->size))
+#endif
 #else
 #define LOG_REAL_SIZE_ALLOC(header, ptr)
 #define LOG_REAL_SIZE_FREE(header, ptr)
+#endif
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+#define LMT_SET_SIZE_CLASS(chunk, index, sizeClass, count) chunk->allocSizeClass[index] = sizeClass; chunk->sizeClassCount[index] = count
+#define LMT_ADD_SIZE_CLASS(chunk, index) chunk->sizeClassCount[index] += 1
+#else
+#define LMT_SET_SIZE_CLASS(chunk, index, sizeClass, count)
+#define LMT_ADD_SIZE_CLASS(chunk, index)
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+#define LMT_SET_SLACK(chunk, index, slack) chunk->allocSlack[index] = slack
+#define LMT_ADD_SLACK(chunk, index, slack) chunk->allocSlack[index] += slack
+	// Only the default heap can be asked for its usable size
+	static LMT_INLINE uint32_t getSlack(void *ptr, size_t size, uint8_t heap)
+	{
+		if (heap != DefaultHeap::ID)
+			return 0;
+		const size_t usable = LMT_USE_USABLE_SIZE(ptr);
+		return usable > size ? uint32_t(usable - size) : 0;
+	}
+#else
+#define LMT_SET_SLACK(chunk, index, slack)
+#define LMT_ADD_SLACK(chunk, index, slack)
+#endif
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+#define LMT_SET_LIVE(chunk, index, header) chunk->allocPtr[index] = (void*)(size_t(header) + HEADER_SIZE); chunk->allocTime[index] = header->time
+#else
+#define LMT_SET_LIVE(chunk, index, header)
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+#define LMT_SET_GENERATION(chunk, index, generation) chunk->allocGeneration[index] = generation
+#else
+#define LMT_SET_GENERATION(chunk, index, generation)
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+#define LMT_SET_FRAME(chunk, index, frame) chunk->allocFrame[index] = frame
+#else
+#define LMT_SET_FRAME(chunk, index, frame)
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+#define LMT_SET_LIFETIME(chunk, index, bucket, count, bytes) chunk->freeLifetime[index] = bucket; chunk->lifetimeCount[index] = count; chunk->lifetimeBytes[index] = bytes
+#else
+#define LMT_SET_LIFETIME(chunk, index, bucket, count, bytes)
+#endif
+#ifdef LMT_CHURN_ACTIVATED
+#define LMT_SET_CHURN(chunk, index, allocs, bytes, frees) chunk->allocCount[index] = allocs; chunk->allocBytes[index] = bytes; chunk->freeCount[index] = frees
+#define LMT_ADD_CHURN(chunk, index, allocs, bytes, frees) chunk->allocCount[index] += allocs; chunk->allocBytes[index] += bytes; chunk->freeCount[index] += frees
+#else
+#define LMT_SET_CHURN(chunk, index, allocs, bytes, frees)
+#define LMT_ADD_CHURN(chunk, index, allocs, bytes, frees)
 #endif
 	static LMT_INLINE void *REGISTER_ALIGNED_PTR(void *ptr, size_t alignment)
 	{
@@ -660,6 +1753,12 @@ namespace LiveMemTracer
 #define IS_ALIGNED(POINTER, BYTE_COUNT) \
 	(((uintptr_t)(const void *)(POINTER)) % (BYTE_COUNT) == 0)
 
+	// Alignments accepted by aligned_alloc and posix_memalign
+	static LMT_INLINE bool isValidAlignment(size_t alignment)
+	{
+		return alignment != 0 && (alignment & (alignment - 1)) == 0;
+	}
+
 #ifdef LMT_STATS
 	struct InternalScope
 	{
@@ -673,147 +1772,342 @@ namespace LiveMemTracer
 #endif
 }
 
-void *LiveMemTracer::alloc(size_t size)
+void *LiveMemTracer::DefaultHeap::allocate(size_t size)
+{
+	return LMT_USE_MALLOC(size);
+}
+
+void *LiveMemTracer::DefaultHeap::reallocate(void *ptr, size_t size)
+{
+	return LMT_USE_REALLOC(ptr, size);
+}
+
+void LiveMemTracer::DefaultHeap::deallocate(void *ptr)
+{
+	LMT_USE_FREE(ptr);
+}
+
+void *LiveMemTracer::registerAlloc(void *ptr, size_t size, uint8_t heap)
 {
-	void *ptr = LMT_USE_MALLOC(size + HEADER_SIZE);
-	void *userPtr = (void*)(size_t(ptr) + HEADER_SIZE);
 	LMT_ASSERT(ptr != nullptr, "Out of memory");
 	if (!ptr)
 		return nullptr;
+	LMT_DEBUG_ASSERT(heap < LMT_HEAP_NUMBER, "Heap ID should be lower than LMT_HEAP_NUMBER");
+	void *userPtr = (void*)(size_t(ptr) + HEADER_SIZE);
 	Header *header = (Header*)(ptr);
-	logAllocInChunk(header, size);
+	header->heap = heap;
+	header->tag = g_th_currentTag;
+#ifdef LMT_USE_USABLE_SIZE
+	header->slack = getSlack(ptr, size + HEADER_SIZE, heap);
+#endif
+	logAllocInChunk(header, size, heap, g_th_currentTag);
 	LOG_REAL_SIZE_ALLOC(header, userPtr);
 	header->aligned = 0;
 	return userPtr;
 }
 
-void *LiveMemTracer::allocAligned(size_t size, size_t alignment)
+void *LiveMemTracer::registerAllocAligned(void *ptr, size_t size, size_t alignment, uint8_t heap)
 {
-	if (alignment < 8)
-	{
-		alignment = 8;
-	}
-
-	size_t allocatedSize = GET_ALIGNED_SIZE(size, alignment);
-	void* r = LMT_USE_MALLOC(allocatedSize);
-	LMT_ASSERT(r != nullptr, "Out of memory");
-	if (!r)
+	LMT_ASSERT(ptr != nullptr, "Out of memory");
+	if (!ptr)
 		return nullptr;
-	void* o = REGISTER_ALIGNED_PTR(r, alignment);
+	LMT_DEBUG_ASSERT(heap < LMT_HEAP_NUMBER, "Heap ID should be lower than LMT_HEAP_NUMBER");
+	void* o = REGISTER_ALIGNED_PTR(ptr, alignment - 1);
 
 	Header* header = GET_HEADER(o);
-	logAllocInChunk(header, size);
+	header->heap = heap;
+	header->tag = g_th_currentTag;
+#ifdef LMT_USE_USABLE_SIZE
+	header->slack = getSlack(ptr, size + alignment - 1 + ALIGNED_HEADER_SIZE, heap);
+#endif
+	logAllocInChunk(header, size, heap, g_th_currentTag);
 	LOG_REAL_SIZE_ALLOC(header, o);
 	header->aligned = 1;
-	LMT_ASSERT(IS_ALIGNED(o, alignment + 1), "Not aligned");
-	LMT_ASSERT(o != nullptr, "");
-	return (void*)o;
+	LMT_ASSERT(IS_ALIGNED(o, alignment), "Not aligned");
+	return o;
 }
 
-void *LiveMemTracer::realloc(void *ptr, size_t size)
+void *LiveMemTracer::unregisterAlloc(void *ptr, uint8_t heap)
 {
-	if (ptr == nullptr)
-	{
-		return alloc(size);
-	}
-
 	Header *header = GET_HEADER(ptr);
-
-	if (size == 0)
-	{
-		dealloc(ptr);
-		return alloc(0);
-	}
-
-	if (size == header->size)
-	{
-		return ptr;
-	}
+	LMT_DEBUG_ASSERT(header->aligned == 0, "Trying to free an aligned ptr with a non-aligned free");
+	LMT_DEBUG_ASSERT(header->heap == heap, "Trying to free a ptr with the wrong heap");
+	(void)heap;
 	logFreeInChunk(header);
 	LOG_REAL_SIZE_FREE(header, ptr);
-	void *newPtr = LMT_USE_REALLOC((void*)header, size + HEADER_SIZE);
-	LMT_ASSERT(newPtr != nullptr, "Out of memory");
-	if (!newPtr)
-		return newPtr;
-	header = (Header*)(newPtr);
-	logAllocInChunk(header, size);
-	void *userPtr = (void*)(size_t(newPtr) + HEADER_SIZE);
-	LOG_REAL_SIZE_ALLOC(header, userPtr);
-	header->aligned = 0;
-	return userPtr;
-}
-
-void *LiveMemTracer::reallocAligned(void *ptr, size_t size, size_t alignment)
-{
-	if (ptr == nullptr)
-	{
-		return allocAligned(size, alignment);
-	}
-
-	Header oldHeader = *GET_HEADER(ptr);
-
-	if (size == 0)
-	{
-		deallocAligned(ptr);
-		return allocAligned(0, alignment);
-	}
-
-	if (size == oldHeader.size)
-	{
-		return ptr;
-	}
-	LMT_ASSERT(oldHeader.aligned == 1, "");
-	LMT_ASSERT(IS_ALIGNED(ptr, alignment), "");
-	void *newPtr = allocAligned(size, alignment);
-	if (!newPtr)
-		return nullptr;
-	memcpy(newPtr, ptr, size_t(oldHeader.size < size ? oldHeader.size : size));
-	deallocAligned(ptr);
-	LMT_ASSERT(IS_ALIGNED(newPtr, alignment), "");
-	LMT_ASSERT(newPtr != nullptr, "");
-	return newPtr;
-	/*size_t reallocSize = GET_ALIGNED_SIZE(size, alignment);
-	void *alignedPtr = GET_ALIGNED_PTR(ptr);
-	void* r = LMT_USE_REALLOC(alignedPtr, reallocSize);
-	if (!r) return NULL;
-	void* o = REGISTER_ALIGNED_PTR(r, alignment);
-
-	Header *newHeader = GET_HEADER(o);
-	logAllocInChunk(newHeader, size);
-	newHeader->aligned = 1;
-	newHeader->size = size;
-	logFreeInChunk(&oldHeader);
-	return o;*/
+	return (void*)header;
 }
 
-void LiveMemTracer::dealloc(void *ptr)
+void *LiveMemTracer::unregisterAllocAligned(void *ptr, uint8_t heap)
 {
-	if (ptr == nullptr)
-		return;
 	Header *header = GET_HEADER(ptr);
-	LMT_DEBUG_ASSERT(header->aligned == 0, "Trying to free an aligned ptr with a non-aligned free");
+	LMT_DEBUG_ASSERT(header->aligned == 1, "Trying to free an non-aligned ptr with an aligned free");
+	LMT_DEBUG_ASSERT(header->heap == heap, "Trying to free a ptr with the wrong heap");
+	(void)heap;
 	logFreeInChunk(header);
 	LOG_REAL_SIZE_FREE(header, ptr);
-	LMT_USE_FREE((void*)header);
+	return GET_ALIGNED_PTR(ptr);
 }
 
-void LiveMemTracer::deallocAligned(void *ptr)
+void LiveMemTracer::registerHeap(uint8_t heap, const char *name)
 {
-	if (ptr == nullptr)
+	LMT_ASSERT(heap < LMT_HEAP_NUMBER, "Heap ID should be lower than LMT_HEAP_NUMBER");
+	if (heap >= LMT_HEAP_NUMBER)
 		return;
-	Header *header = GET_HEADER(ptr);
-	LMT_DEBUG_ASSERT(header->aligned == 1, "Trying to free an non-aligned ptr with an aligned free");
-	logFreeInChunk(header);
-	LOG_REAL_SIZE_FREE(header, ptr);
-	LMT_USE_FREE(GET_ALIGNED_PTR(ptr));
+	g_heapNames[heap] = name;
 }
 
-void LiveMemTracer::exit()
+uint8_t LiveMemTracer::registerTag(const char *name)
 {
-	g_runningStatus = EXIT;
+	std::lock_guard<std::mutex> lock(g_tagMutex);
+	const uint16_t count = g_tagCounter.load();
+	for (uint16_t i = 1; i < count; ++i)
+	{
+		if (strcmp(g_tagNames[i], name) == 0)
+			return uint8_t(i);
+	}
+	LMT_DEBUG_ASSERT(count < LMT_TAG_NUMBER, "Too many tags, increase LMT_TAG_NUMBER");
+	if (count >= LMT_TAG_NUMBER)
+		return 0;
+	g_tagNames[count] = name;
+	g_tagCounter.store(uint16_t(count + 1));
+	return uint8_t(count);
 }
 
-void LiveMemTracer::init()
+uint8_t LiveMemTracer::pushTag(uint8_t tag)
+{
+	const uint8_t previous = g_th_currentTag;
+	g_th_currentTag = tag;
+	return previous;
+}
+
+void LiveMemTracer::popTag(uint8_t previous)
+{
+	g_th_currentTag = previous;
+}
+
+void LiveMemTracer::setTagBudget(const char *name, size_t budget)
+{
+	const uint8_t tag = registerTag(name);
+	// Tag table is full, don't put the budget on "Untagged"
+	LMT_ASSERT(tag != 0, "Too many tags, increase LMT_TAG_NUMBER");
+	if (tag == 0)
+		return;
+	std::lock_guard<std::mutex> lock(g_mutex);
+	g_tagBudgets[tag] = budget;
+	g_tagOverBudget[tag] = false;
+}
+
+void LiveMemTracer::setTagBudgetCallback(TagBudgetCallback callback)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+	g_tagBudgetCallback = callback;
+}
+
+void LiveMemTracer::poolAlloc(uint8_t pool, void *ptr, size_t size)
+{
+	LMT_DEBUG_ASSERT(pool < LMT_POOL_NUMBER, "Pool ID should be lower than LMT_POOL_NUMBER");
+	if (ptr == nullptr || pool >= LMT_POOL_NUMBER)
+		return;
+	logPoolAllocInChunk(pool, ptr, size);
+}
+
+void LiveMemTracer::poolFree(uint8_t pool, void *ptr)
+{
+	LMT_DEBUG_ASSERT(pool < LMT_POOL_NUMBER, "Pool ID should be lower than LMT_POOL_NUMBER");
+	if (ptr == nullptr || pool >= LMT_POOL_NUMBER)
+		return;
+	logPoolFreeInChunk(pool, ptr);
+}
+
+void LiveMemTracer::trackResource(uint8_t kind, size_t handle, size_t size)
+{
+	LMT_DEBUG_ASSERT(kind < LMT_RESOURCE_KIND_NUMBER, "Resource kind should be lower than LMT_RESOURCE_KIND_NUMBER");
+	if (kind >= LMT_RESOURCE_KIND_NUMBER)
+		return;
+	// Handle can be 0 (file descriptors...), +1 so it's never the empty key
+	logPoolAllocInChunk(uint8_t(LMT_POOL_NUMBER + kind), (void*)(handle + 1), size);
+}
+
+void LiveMemTracer::untrackResource(uint8_t kind, size_t handle)
+{
+	LMT_DEBUG_ASSERT(kind < LMT_RESOURCE_KIND_NUMBER, "Resource kind should be lower than LMT_RESOURCE_KIND_NUMBER");
+	if (kind >= LMT_RESOURCE_KIND_NUMBER)
+		return;
+	logPoolFreeInChunk(uint8_t(LMT_POOL_NUMBER + kind), (void*)(handle + 1));
+}
+
+void LiveMemTracer::logPoolAllocInChunk(uint8_t pool, void *ptr, size_t size)
+{
+	INTERNAL_SCOPE;
+	Chunk *chunk = getChunk();
+
+	Hash hash = 0;
+	void **stack = &chunk->stackBuffer[chunk->stackIndex];
+	uint32_t count = getCallstack(LMT_STACK_SIZE_PER_ALLOC, stack, &hash);
+	// Pool stacks are placed under the pool root, they can't share
+	// the AllocStack of the same call stack outside of the pool
+	hash = combineHash(pool, hash);
+
+	// Events are never merged, each one carry its pointer,
+	// but frames are shared with the previous event of the same stack
+	size_t index = chunk->allocIndex;
+	uint8_t found = findInCache(hash);
+	if (found != uint8_t(-1) && chunk->allocPool[chunk->allocIndex - found - 1] == pool + 1)
+	{
+		chunk->allocStackIndex[index] = chunk->allocStackIndex[chunk->allocIndex - found - 1];
+		chunk->allocStackSize[index] = chunk->allocStackSize[chunk->allocIndex - found - 1];
+	}
+	else
+	{
+		chunk->allocStackIndex[index] = chunk->stackIndex;
+		chunk->allocStackSize[index] = count;
+		chunk->stackIndex += count;
+	}
+	chunk->allocSize[index] = size;
+	chunk->allocHash[index] = hash;
+	chunk->allocHeap[index] = 0;
+	chunk->allocTag[index] = 0;
+	chunk->allocPool[index] = pool + 1;
+	chunk->allocPtr[index] = ptr;
+	chunk->allocTime[index] = g_poolSequence.fetch_add(1, std::memory_order_relaxed);
+	LMT_SET_CHURN(chunk, index, 1, size, 0);
+	LMT_SET_FRAME(chunk, index, g_frameIndex.load(std::memory_order_relaxed));
+	g_th_cache[g_th_cacheIndex] = hash;
+	g_th_cacheIndex = (g_th_cacheIndex + 1) % LMT_CACHE_SIZE;
+	chunk->allocIndex += 1;
+}
+
+void LiveMemTracer::logPoolFreeInChunk(uint8_t pool, void *ptr)
+{
+	INTERNAL_SCOPE;
+	Chunk *chunk = getChunk();
+
+	// Size and stack are unknown here, they'll be found in the pool table
+	size_t index = chunk->allocIndex;
+	chunk->allocStackIndex[index] = size_t(-1);
+	chunk->allocStackSize[index] = 0;
+	chunk->allocSize[index] = 0;
+	chunk->allocHash[index] = 0;
+	chunk->allocHeap[index] = 0;
+	chunk->allocTag[index] = 0;
+	chunk->allocPool[index] = pool + 1;
+	chunk->allocPtr[index] = ptr;
+	chunk->allocTime[index] = g_poolSequence.fetch_add(1, std::memory_order_relaxed);
+	LMT_SET_CHURN(chunk, index, 0, 0, 1);
+	LMT_SET_FRAME(chunk, index, g_frameIndex.load(std::memory_order_relaxed));
+	g_th_cache[g_th_cacheIndex] = 0;
+	g_th_cacheIndex = (g_th_cacheIndex + 1) % LMT_CACHE_SIZE;
+	chunk->allocIndex += 1;
+}
+
+void LiveMemTracer::registerPool(uint8_t pool, const char *name, void *base, size_t capacity)
+{
+	LMT_ASSERT(pool < LMT_POOL_NUMBER, "Pool ID should be lower than LMT_POOL_NUMBER");
+	if (pool >= LMT_POOL_NUMBER)
+		return;
+	std::lock_guard<std::mutex> lock(g_mutex);
+	Pool &p = g_pools[pool];
+	p.name = name;
+	p.base = base;
+	p.capacity = capacity;
+	LMT_SNPRINTF(p.rootName, sizeof(p.rootName), "[Pool] %s", name);
+}
+
+void LiveMemTracer::registerResourceKind(uint8_t kind, const char *name)
+{
+	LMT_ASSERT(kind < LMT_RESOURCE_KIND_NUMBER, "Resource kind should be lower than LMT_RESOURCE_KIND_NUMBER");
+	if (kind >= LMT_RESOURCE_KIND_NUMBER)
+		return;
+	std::lock_guard<std::mutex> lock(g_mutex);
+	Pool &p = g_pools[LMT_POOL_NUMBER + kind];
+	p.name = name;
+	LMT_SNPRINTF(p.rootName, sizeof(p.rootName), "[Resource] %s", name);
+}
+
+void LiveMemTracer::addFoldPrefix(const char *prefix)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+	LMT_ASSERT(g_foldRuleCount < LMT_FOLD_RULE_NUMBER, "Too many fold rules, increase LMT_FOLD_RULE_NUMBER");
+	if (g_foldRuleCount >= LMT_FOLD_RULE_NUMBER)
+		return;
+	FoldRule &rule = g_foldRules[g_foldRuleCount++];
+	rule.prefix = prefix;
+	rule.prefixLength = strlen(prefix);
+	rule.begin = rule.end = 0;
+}
+
+void LiveMemTracer::addFoldRange(const void *begin, const void *end)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+	LMT_ASSERT(g_foldRuleCount < LMT_FOLD_RULE_NUMBER, "Too many fold rules, increase LMT_FOLD_RULE_NUMBER");
+	if (g_foldRuleCount >= LMT_FOLD_RULE_NUMBER)
+		return;
+	FoldRule &rule = g_foldRules[g_foldRuleCount++];
+	rule.prefix = nullptr;
+	rule.prefixLength = 0;
+	rule.begin = uintptr_t(begin);
+	rule.end = uintptr_t(end);
+}
+
+void *LiveMemTracer::calloc(size_t count, size_t size)
+{
+	if (size != 0 && count > (size_t(-1) - HEADER_SIZE) / size)
+		return nullptr;
+	size *= count;
+#ifdef LMT_USE_CALLOC
+	// Forward to the real calloc so that large blocks keep getting
+	// already zeroed pages from the system
+	void *ptr = LMT_USE_CALLOC(1, size + HEADER_SIZE);
+#else
+	void *ptr = LMT_USE_MALLOC(size + HEADER_SIZE);
+	if (ptr)
+		memset(ptr, 0, size + HEADER_SIZE);
+#endif
+	return registerAlloc(ptr, size, DefaultHeap::ID);
+}
+
+void *LiveMemTracer::alignedAlloc(size_t alignment, size_t size)
+{
+	if (!isValidAlignment(alignment))
+	{
+		errno = EINVAL;
+		return nullptr;
+	}
+	// Memory have to be released with LMT_DEALLOC_ALIGNED
+	return allocAligned(size, alignment);
+}
+
+int LiveMemTracer::posixMemalign(void **memptr, size_t alignment, size_t size)
+{
+	if (!isValidAlignment(alignment) || alignment % sizeof(void*) != 0)
+		return EINVAL;
+	// Memory have to be released with LMT_DEALLOC_ALIGNED
+	void *ptr = allocAligned(size, alignment);
+	if (!ptr)
+		return ENOMEM;
+	*memptr = ptr;
+	return 0;
+}
+
+size_t LiveMemTracer::usableSize(void *ptr)
+{
+	if (ptr == nullptr)
+		return 0;
+	Header *header = GET_HEADER(ptr);
+	return size_t(header->size);
+}
+
+void LiveMemTracer::exit()
+{
+#ifdef LMT_LEAK_REPORT
+	flushCurrentChunk();
+	writeLeakReport(LMT_LEAK_REPORT_PATH);
+#endif
+	g_runningStatus = EXIT;
+}
+
+void LiveMemTracer::init()
 {
 	INTERNAL_SCOPE;
 	g_runningStatus = RUNNING;
@@ -825,11 +2119,87 @@ void LiveMemTracer::init()
 // IMPL ONLY : 
 //////////////////////////////////////////////////////////////////////////
 
-#ifdef LMT_x64
-#define LMT_HASH_FROM_PTR(ptr) combineHash(ptr)
-#else
-#define LMT_HASH_FROM_PTR(ptr) Hash(ptr)
+namespace LiveMemTracer
+{
+	static LMT_INLINE uint8_t internalSizeClass(size_t size)
+	{
+		uint8_t sizeClass = 0;
+		while ((INTERNAL_MIN_BLOCK << sizeClass) < size)
+			++sizeClass;
+		return sizeClass;
+	}
+}
+
+void *LiveMemTracer::internalAlloc(size_t size)
+{
+	if (size > INTERNAL_MAX_BLOCK)
+	{
+		void *ptr = LMT_USE_MALLOC(size);
+		LMT_ASSERT(ptr != nullptr, "Out of memory");
+#ifdef LMT_STATS
+		if (ptr)
+			g_internalAllocations.fetch_add(size);
+#endif
+		return ptr;
+	}
+	const uint8_t sizeClass = internalSizeClass(size);
+	const size_t blockSize = INTERNAL_MIN_BLOCK << sizeClass;
+
+	std::lock_guard<std::mutex> lock(g_internalMutex);
+	InternalBlock *block = g_internalFreeLists[sizeClass];
+	if (block)
+	{
+		g_internalFreeLists[sizeClass] = block->next;
+		return block;
+	}
+	if (size_t(g_internalPageEnd - g_internalPageCursor) < blockSize)
+	{
+		// What remain of the current page is given to the free lists
+		size_t left = size_t(g_internalPageEnd - g_internalPageCursor);
+		while (left >= INTERNAL_MIN_BLOCK)
+		{
+			uint8_t leftClass = internalSizeClass(left);
+			if ((INTERNAL_MIN_BLOCK << leftClass) > left)
+				--leftClass;
+			InternalBlock *leftBlock = (InternalBlock*)g_internalPageCursor;
+			leftBlock->next = g_internalFreeLists[leftClass];
+			g_internalFreeLists[leftClass] = leftBlock;
+			g_internalPageCursor += INTERNAL_MIN_BLOCK << leftClass;
+			left -= INTERNAL_MIN_BLOCK << leftClass;
+		}
+		char *page = (char*)LMT_USE_MALLOC(LMT_INTERNAL_PAGE_SIZE);
+		LMT_ASSERT(page != nullptr, "Out of memory");
+		if (page == nullptr)
+			return nullptr;
+#ifdef LMT_STATS
+		g_internalAllocations.fetch_add(LMT_INTERNAL_PAGE_SIZE);
+#endif
+		g_internalPageCursor = page;
+		g_internalPageEnd = page + (LMT_INTERNAL_PAGE_SIZE);
+	}
+	void *ptr = g_internalPageCursor;
+	g_internalPageCursor += blockSize;
+	return ptr;
+}
+
+void LiveMemTracer::internalFree(void *ptr, size_t size)
+{
+	if (ptr == nullptr)
+		return;
+	if (size > INTERNAL_MAX_BLOCK)
+	{
+		LMT_USE_FREE(ptr);
+#ifdef LMT_STATS
+		g_internalAllocations.fetch_sub(size);
 #endif
+		return;
+	}
+	const uint8_t sizeClass = internalSizeClass(size);
+	std::lock_guard<std::mutex> lock(g_internalMutex);
+	InternalBlock *block = (InternalBlock*)ptr;
+	block->next = g_internalFreeLists[sizeClass];
+	g_internalFreeLists[sizeClass] = block;
+}
 
 bool LiveMemTracer::chunkIsNotFull(const Chunk *chunk)
 {
@@ -977,7 +2347,7 @@ uint8_t LiveMemTracer::findInCache(LiveMemTracer::Hash hash)
 	return uint8_t(-1);
 }
 
-void LiveMemTracer::logAllocInChunk(LiveMemTracer::Header *header, size_t size)
+void LiveMemTracer::logAllocInChunk(LiveMemTracer::Header *header, size_t size, uint8_t heap, uint8_t tag)
 {
 #ifdef LMT_STATS
 	if (IS_IN_INTERNAL_SCOPE())
@@ -993,24 +2363,67 @@ void LiveMemTracer::logAllocInChunk(LiveMemTracer::Header *header, size_t size)
 	uint32_t count = getCallstack(LMT_STACK_SIZE_PER_ALLOC, stack, &header->hash);
 
 	header->size = size;
+#ifdef LMT_HEADER_TIME
+	header->time = LMT_TIMESTAMP();
+#endif
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+	const uint8_t sizeClass = getSizeClass(size);
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+	const uint32_t frame = g_frameIndex.load(std::memory_order_relaxed);
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+	header->generation = g_generation.load(std::memory_order_relaxed);
+#endif
 
 	size_t index = chunk->allocIndex;
 	uint8_t found = findInCache(header->hash);
-	if (found != uint8_t(-1))
+	if (found != uint8_t(-1)
+		&& chunk->allocHeap[chunk->allocIndex - found - 1] == heap
+		&& chunk->allocTag[chunk->allocIndex - found - 1] == tag
+		&& chunk->allocPool[chunk->allocIndex - found - 1] == 0
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+		&& chunk->allocSizeClass[chunk->allocIndex - found - 1] == sizeClass
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+		&& chunk->allocFrame[chunk->allocIndex - found - 1] == frame
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+		&& chunk->allocGeneration[chunk->allocIndex - found - 1] == header->generation
+#endif
+		)
 	{
-#ifndef LMT_INSTANCE_COUNT_ACTIVATED
+		// Events are not merged when they are counted or when they carry their pointer
+#if !defined(LMT_INSTANCE_COUNT_ACTIVATED) && !defined(LMT_LIVE_TABLE_ACTIVATED)
 		index = chunk->allocIndex - found - 1;
 		chunk->allocSize[index] += size;
+		LMT_ADD_CHURN(chunk, index, 1, size, 0);
+		LMT_ADD_SIZE_CLASS(chunk, index);
+		LMT_ADD_SLACK(chunk, index, header->slack);
 		return;
 #else
-		chunk->allocStackIndex[index] = chunk->allocStackIndex[chunk->allocIndex - found - 1];
-		chunk->allocSize[index] = size;
-		chunk->allocHash[index] = chunk->allocHash[chunk->allocIndex - found - 1];
-		chunk->allocStackSize[index] = chunk->allocStackSize[chunk->allocIndex - found - 1];
-		chunk->allocIndex += 1;
-		g_th_cache[g_th_cacheIndex] = header->hash;
-		g_th_cacheIndex = (g_th_cacheIndex + 1) % LMT_CACHE_SIZE;
-		return;
+		// A free event has no frames to share, the captured ones are kept
+		if (chunk->allocStackIndex[chunk->allocIndex - found - 1] != size_t(-1))
+		{
+			chunk->allocStackIndex[index] = chunk->allocStackIndex[chunk->allocIndex - found - 1];
+			chunk->allocSize[index] = size;
+			chunk->allocHash[index] = chunk->allocHash[chunk->allocIndex - found - 1];
+			chunk->allocStackSize[index] = chunk->allocStackSize[chunk->allocIndex - found - 1];
+			chunk->allocHeap[index] = heap;
+			chunk->allocTag[index] = tag;
+			chunk->allocPool[index] = 0;
+			LMT_SET_CHURN(chunk, index, 1, size, 0);
+			LMT_SET_SIZE_CLASS(chunk, index, sizeClass, 1);
+			LMT_SET_LIFETIME(chunk, index, 0, 0, 0);
+			LMT_SET_FRAME(chunk, index, frame);
+			LMT_SET_SLACK(chunk, index, header->slack);
+			LMT_SET_GENERATION(chunk, index, header->generation);
+			LMT_SET_LIVE(chunk, index, header);
+			chunk->allocIndex += 1;
+			g_th_cache[g_th_cacheIndex] = header->hash;
+			g_th_cacheIndex = (g_th_cacheIndex + 1) % LMT_CACHE_SIZE;
+			return;
+		}
 #endif
 	}
 
@@ -1018,6 +2431,16 @@ void LiveMemTracer::logAllocInChunk(LiveMemTracer::Header *header, size_t size)
 	chunk->allocSize[index] = size;
 	chunk->allocHash[index] = header->hash;
 	chunk->allocStackSize[index] = count;
+	chunk->allocHeap[index] = heap;
+	chunk->allocTag[index] = tag;
+	chunk->allocPool[index] = 0;
+	LMT_SET_CHURN(chunk, index, 1, size, 0);
+	LMT_SET_SIZE_CLASS(chunk, index, sizeClass, 1);
+	LMT_SET_LIFETIME(chunk, index, 0, 0, 0);
+	LMT_SET_FRAME(chunk, index, frame);
+	LMT_SET_SLACK(chunk, index, header->slack);
+	LMT_SET_GENERATION(chunk, index, header->generation);
+	LMT_SET_LIVE(chunk, index, header);
 	g_th_cache[g_th_cacheIndex] = header->hash;
 	g_th_cacheIndex = (g_th_cacheIndex + 1) % LMT_CACHE_SIZE;
 	chunk->allocIndex += 1;
@@ -1034,14 +2457,36 @@ void LiveMemTracer::logFreeInChunk(LiveMemTracer::Header *header)
 #endif
 	INTERNAL_SCOPE;
 	Chunk *chunk = getChunk();
+#ifdef LMT_LIFETIME_ACTIVATED
+	const uint8_t lifetime = getLifetimeBucket(LMT_TIMESTAMP() - header->time);
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+	const uint32_t frame = g_frameIndex.load(std::memory_order_relaxed);
+#endif
 
 	size_t index = chunk->allocIndex;
 	uint8_t found = findInCache(header->hash);
-	if (found != uint8_t(-1))
+	if (found != uint8_t(-1)
+		&& chunk->allocHeap[chunk->allocIndex - found - 1] == header->heap
+		&& chunk->allocTag[chunk->allocIndex - found - 1] == header->tag
+		&& chunk->allocPool[chunk->allocIndex - found - 1] == 0
+#ifdef LMT_LIFETIME_ACTIVATED
+		&& (chunk->lifetimeCount[chunk->allocIndex - found - 1] == 0 || chunk->freeLifetime[chunk->allocIndex - found - 1] == lifetime)
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+		&& chunk->allocFrame[chunk->allocIndex - found - 1] == frame
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+		&& chunk->allocGeneration[chunk->allocIndex - found - 1] == header->generation
+#endif
+		)
 	{
-#ifndef LMT_INSTANCE_COUNT_ACTIVATED
+#if !defined(LMT_INSTANCE_COUNT_ACTIVATED) && !defined(LMT_LIVE_TABLE_ACTIVATED)
 		index = chunk->allocIndex - found - 1;
 		chunk->allocSize[index] -= ptrdiff_t(header->size);
+		LMT_ADD_CHURN(chunk, index, 0, 0, 1);
+		LMT_SET_LIFETIME(chunk, index, lifetime, chunk->lifetimeCount[index] + 1, chunk->lifetimeBytes[index] + header->size);
+		LMT_ADD_SLACK(chunk, index, -ptrdiff_t(header->slack));
 		return;
 #endif
 	}
@@ -1052,6 +2497,16 @@ void LiveMemTracer::logFreeInChunk(LiveMemTracer::Header *header)
 	chunk->allocSize[index] = -ptrdiff_t(header->size);
 	chunk->allocHash[index] = header->hash;
 	chunk->allocStackSize[index] = 0;
+	chunk->allocHeap[index] = uint8_t(header->heap);
+	chunk->allocTag[index] = uint8_t(header->tag);
+	chunk->allocPool[index] = 0;
+	LMT_SET_CHURN(chunk, index, 0, 0, 1);
+	LMT_SET_SIZE_CLASS(chunk, index, getSizeClass(header->size), 0);
+	LMT_SET_LIFETIME(chunk, index, lifetime, 1, header->size);
+	LMT_SET_FRAME(chunk, index, frame);
+	LMT_SET_SLACK(chunk, index, -ptrdiff_t(header->slack));
+	LMT_SET_GENERATION(chunk, index, header->generation);
+	LMT_SET_LIVE(chunk, index, header);
 	chunk->allocIndex += 1;
 }
 
@@ -1061,705 +2516,2264 @@ void LiveMemTracer::logFreeInChunk(LiveMemTracer::Header *header)
 #define LMT_INC_INSTANCE(instance, size)
 #endif
 
+// Allocations and frees merged in an event can cancel its size,
+// but not the counters of the event
+bool LiveMemTracer::isEmptyEvent(const Chunk *chunk, size_t index)
+{
+	(void)chunk; (void)index;
+	return true
+#ifdef LMT_CHURN_ACTIVATED
+		&& chunk->allocCount[index] == 0 && chunk->freeCount[index] == 0
+#endif
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+		&& chunk->sizeClassCount[index] == 0
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+		&& chunk->lifetimeCount[index] == 0
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+		&& chunk->allocSlack[index] == 0
+#endif
+		;
+}
+
+// Called with the lock held, a tag going over its budget several times
+// in the same chunk is reported once with its last size
+void LiveMemTracer::addTagBudgetCrossing(TagBudgetCrossing *crossings, size_t &count, uint8_t tag)
+{
+	size_t i = 0;
+	while (i < count && crossings[i].tag != tag)
+		++i;
+	if (i == count)
+		++count;
+	crossings[i].tag = tag;
+	crossings[i].budget = g_tagBudgets[tag];
+	crossings[i].allocSize = size_t(g_tagAllocSize[tag]);
+}
+
 void LiveMemTracer::treatChunk(Chunk *chunk)
 {
-	INTERNAL_SCOPE;
-	std::lock_guard<std::mutex> lock(g_mutex);
-	for (size_t i = 0, iend = chunk->allocIndex; i < iend; ++i)
+	// Budget callbacks are called once the lock is released,
+	// they can log or allocate without dead locking
+	TagBudgetCrossing crossings[LMT_TAG_NUMBER];
+	size_t crossingCount = 0;
+	TagBudgetCallback callback = nullptr;
 	{
-		auto size = chunk->allocSize[i];
-		if (size == 0)
-			continue;
-		auto it = g_stackDictionary.update(chunk->allocHash[i]);
-		auto &allocStack = it->getValue();
-		allocStack.allocSize += size;
-		if (allocStack.stackSize != 0)
-		{
-			updateTree(allocStack, size, false);
-			for (size_t j = 0; j < allocStack.stackSize; ++j)
-			{
-				allocStack.stackAllocs[j]->allocSize += size;
-			}
-			continue;
-		}
-		allocStack.hash = chunk->allocHash[i];
-		allocStack.stackAllocs.resize(chunk->allocStackSize[i]);
-		for (size_t j = 0, jend = chunk->allocStackSize[i]; j < jend; ++j)
+		INTERNAL_SCOPE;
+		std::lock_guard<std::mutex> lock(g_mutex);
+		callback = g_tagBudgetCallback;
+		for (size_t i = 0, iend = chunk->allocIndex; i < iend; ++i)
 		{
-			void *addr = chunk->stackBuffer[chunk->allocStackIndex[i] + j];
-			auto found = g_allocDictionary.update(LMT_HASH_FROM_PTR(addr));
-			if (found->getValue().shared != nullptr)
+			if (chunk->allocPool[i] != 0)
 			{
-				auto shared = found->getValue().shared;
-				shared->allocSize += size;
-				allocStack.stackAllocs[j] = shared;
+				treatPoolEvent(chunk, i);
 				continue;
 			}
-			if (found->getValue().str != nullptr)
-			{
-				allocStack.stackAllocs[j] = &found->getValue();
-				found->getValue().allocSize += size;
+			auto size = chunk->allocSize[i];
+			if (size == 0 && isEmptyEvent(chunk, i))
 				continue;
+			g_heapAllocSize[chunk->allocHeap[i]] += size;
+			const uint8_t tag = chunk->allocTag[i];
+			g_tagAllocSize[tag] += size;
+			if (g_tagBudgets[tag] != 0)
+			{
+				const bool overBudget = g_tagAllocSize[tag] > ptrdiff_t(g_tagBudgets[tag]);
+				if (overBudget && !g_tagOverBudget[tag] && callback)
+				{
+					addTagBudgetCrossing(crossings, crossingCount, tag);
+				}
+				g_tagOverBudget[tag] = overBudget;
 			}
-			void *absoluteAddress = nullptr;
-			const char *name = SymbolGetter::getSymbol(addr, absoluteAddress);
-
-			auto shared = g_allocDictionary.update(LMT_HASH_FROM_PTR(absoluteAddress));
-			if (shared->getValue().str != nullptr)
+			AllocStack &allocStack = updateStack(chunk, i, chunk->allocHash[i], size, getChurn(chunk, i), nullptr);
+			(void)allocStack;
+#ifdef LMT_PEAK_ACTIVATED
+			updatePeak(size);
+#endif
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+			if (chunk->sizeClassCount[i] != 0)
 			{
-				found->getValue().shared = &shared->getValue();
-				allocStack.stackAllocs[j] = &shared->getValue();
-				shared->getValue().allocSize += size;
-#ifdef LMT_PLATFORM_WINDOWS
-				if (name != TRUNCATED_STACK_NAME)
-					LMT_USE_FREE((void*)name);
+				addSizeClass(allocStack, chunk->allocSizeClass[i], chunk->sizeClassCount[i]);
+			}
 #endif
-				continue;
+#ifdef LMT_LIFETIME_ACTIVATED
+			if (chunk->lifetimeCount[i] != 0)
+			{
+				addLifetime(allocStack, chunk->freeLifetime[i], chunk->lifetimeCount[i], chunk->lifetimeBytes[i]);
 			}
-
-			found->getValue().shared = &shared->getValue();
-			shared->getValue().str = name;
-			shared->getValue().allocSize = size;
-
-			allocStack.stackAllocs[j] = &shared->getValue();
-			shared->getValue().next = g_allocList;
-			g_allocList = &shared->getValue();
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+			allocStack.slackSize += chunk->allocSlack[i];
+			g_slackSize += chunk->allocSlack[i];
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+			addGeneration(allocStack, chunk->allocGeneration[i], size);
+#endif
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+			treatLiveEvent(chunk, i);
+#endif
 		}
-		allocStack.stackSize = chunk->allocStackSize[i];
-		updateTree(allocStack, size, true);
-	}
-	if (chunk->status == ChunkStatus::TEMPORARY)
-	{
-		chunk->~Chunk();
-		LMT_USE_FREE(chunk);
+		if (chunk->status == ChunkStatus::TEMPORARY)
+		{
+			chunk->~Chunk();
+			LMT_USE_FREE(chunk);
 #ifdef LMT_STATS
-		g_internalAllocations.fetch_sub(sizeof(Chunk));
+			g_internalAllocations.fetch_sub(sizeof(Chunk));
 #endif
-		g_temporaryChunkCounter.fetch_sub(1);
+			g_temporaryChunkCounter.fetch_sub(1);
+		}
+		else
+		{
+			chunk->status.store(ChunkStatus::TREATED);
+		}
 	}
-	else
+	for (size_t i = 0; i < crossingCount; ++i)
 	{
-		chunk->status.store(ChunkStatus::TREATED);
+		const TagBudgetCrossing &crossing = crossings[i];
+		callback(g_tagNames[crossing.tag], crossing.budget, crossing.allocSize);
 	}
 }
 
-void LiveMemTracer::updateTree(AllocStack &allocStack, ptrdiff_t size, bool checkTree)
+LiveMemTracer::AllocStack &LiveMemTracer::updateStack(const Chunk *chunk, size_t index, Hash hash, ptrdiff_t size, const Churn &churn, Alloc *root)
 {
-	int stackSize = allocStack.stackSize;
-	stackSize -= INTERNAL_FRAME_TO_SKIP;
-	uint8_t depth = 0;
-	Edge *previousPtr = nullptr;
-	while (stackSize >= 0)
+	auto it = g_stackDictionary.update(hash);
+	auto &allocStack = it->getValue();
+	allocStack.allocSize += size;
+	LMT_INC_INSTANCE(allocStack.instanceCount, size);
+#ifdef LMT_PEAK_ACTIVATED
+	if (allocStack.allocSize > allocStack.peakSize)
+		allocStack.peakSize = allocStack.allocSize;
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+	updateFrame(chunk->allocFrame[index], allocStack, churn);
+#endif
+#ifdef LMT_CHURN_ACTIVATED
+	addChurn(allocStack.churn, churn);
+#endif
+#ifdef LMT_STACK_VERIFY
+	// Each chunk carry frames for its first event of a stack,
+	// we check that they are the same as the ones stored at the stack creation
+	const size_t frameCount = chunk->allocStackIndex[index] != size_t(-1) ? chunk->allocStackSize[index] : 0;
+	if (allocStack.stackSize != 0 && frameCount != 0)
 	{
-		Hash currentHash = LMT_HASH_FROM_PTR(allocStack.stackAllocs[stackSize]);
-		currentHash = combineHash((size_t(previousPtr)), currentHash);
-		currentHash = combineHash(depth * depth, currentHash);
-
-		TreeKey key(currentHash, LMT_HASH_FROM_PTR(allocStack.stackAllocs[stackSize]->str));
-
-		auto pair = g_treeDictionary.update(key);
-		Edge *currentPtr = &pair->getValue();
-		currentPtr->allocSize += size;
-		LMT_INC_INSTANCE(currentPtr->instanceCount, size);
-		if (checkTree)
+		const void * const *frames = &chunk->stackBuffer[chunk->allocStackIndex[index]];
+		bool same = frameCount == size_t(allocStack.frames.end() - allocStack.frames.begin());
+		for (size_t j = 0; same && j < frameCount; ++j)
 		{
-			if (!currentPtr->alloc)
-			{
-				LMT_DEBUG_ASSERT(currentPtr->same == nullptr, "Edge already have a same pointer defined.");
-				currentPtr->alloc = allocStack.stackAllocs[stackSize];
-				currentPtr->same = allocStack.stackAllocs[stackSize]->edges;
-				allocStack.stackAllocs[stackSize]->edges = currentPtr;
-			}
-
-			if (previousPtr != nullptr)
-			{
-				auto it = std::find(previousPtr->to.begin(), previousPtr->to.end(), currentPtr);
-				if (it == previousPtr->to.end())
-				{
-					previousPtr->to.push_back(currentPtr);
-				}
-				currentPtr->from = previousPtr;
-			}
-			else
-			{
-				auto it = std::find(g_allocStackRoots.begin(), g_allocStackRoots.end(), currentPtr);
-				if (it == g_allocStackRoots.end())
-					g_allocStackRoots.push_back(currentPtr);
-			}
-
-			currentPtr->depth = depth;
+			same = allocStack.frames[j] == frames[j];
+		}
+		if (!same)
+		{
+			++g_stackCollisions;
+			LMT_DEBUG_ASSERT(false, "LMT : Stack hash collision.");
 		}
-		LMT_DEBUG_ASSERT(strcmp(currentPtr->alloc->str, allocStack.stackAllocs[stackSize]->str) == 0, "Name collision.");
-
-		previousPtr = currentPtr;
-		++depth;
-		--stackSize;
 	}
-}
-
-template <class T>
-LMT_INLINE LiveMemTracer::Hash LiveMemTracer::combineHash(const T& val, const LiveMemTracer::Hash baseHash)
-{
-	const uint8_t* bytes = (uint8_t*)&val;
-	const size_t count = sizeof(val);
-	const Hash FNV_offset_basis = baseHash;
-	const Hash FNV_prime = 16777619U;
-
-	Hash hash = FNV_offset_basis;
-	for (size_t i = 0; i < count; ++i)
+	else if (frameCount != 0)
 	{
-		hash ^= (Hash)bytes[i];
-		hash *= FNV_prime;
+		allocStack.frames.resize(uint32_t(frameCount));
+		memcpy(allocStack.frames.begin(), &chunk->stackBuffer[chunk->allocStackIndex[index]], frameCount * sizeof(void*));
 	}
-
-	return hash;
-}
-
-#if LMT_IMGUI
-#include LMT_IMGUI_INCLUDE_PATH
-
-namespace LiveMemTracer
-{
-	namespace Renderer
+#endif
+	if (allocStack.stackSize != 0)
 	{
-		static bool SortGroupedEdge(const GroupedEdge &a, const GroupedEdge &b)
+		updateTree(allocStack, size, churn, false);
+		Alloc **stackAllocs = getStackAllocs(allocStack);
+		for (size_t j = 0; j < allocStack.stackSize; ++j)
 		{
-			return a.allocSize > b.allocSize;
+			stackAllocs[j]->allocSize += size;
 		}
-
-		static bool InsertSortedEdge(const GroupedEdge &a, const GroupedEdge &b)
-		{
+		return allocStack;
+	}
+	const uint32_t reserved = chunk->allocStackSize[index] + (root ? 1 : 0);
+	// Free treated before the first allocation of its stack, frames are unknown,
+	// the stack is created (and linked once) by its allocation
+	if (reserved == 0)
+		return allocStack;
+	const uint32_t offset = allocateStackFrames(reserved);
+	if (offset == uint32_t(-1))
+		return allocStack;
+	allocStack.hash = hash;
+	allocStack.stackOffset = offset;
+	allocStack.next = g_allocStackList;
+	g_allocStackList = &allocStack;
+	Alloc **stackAllocs = getStackAllocs(allocStack);
+	for (size_t j = 0, jend = chunk->allocStackSize[index]; j < jend; ++j)
+	{
+		void *addr = chunk->stackBuffer[chunk->allocStackIndex[index] + j];
+		auto found = g_allocDictionary.update(LMT_HASH_FROM_PTR(addr));
+		if (found->getValue().shared != nullptr)
+		{
+			auto shared = found->getValue().shared;
+			shared->allocSize += size;
+			stackAllocs[j] = shared;
+			continue;
+		}
+		if (found->getValue().str != nullptr)
+		{
+			stackAllocs[j] = &found->getValue();
+			found->getValue().allocSize += size;
+			continue;
+		}
+		void *absoluteAddress = nullptr;
+		const char *name = SymbolGetter::getSymbol(addr, absoluteAddress);
+
+		auto shared = g_allocDictionary.update(LMT_HASH_FROM_PTR(absoluteAddress));
+		if (shared->getValue().str != nullptr)
+		{
+			found->getValue().shared = &shared->getValue();
+			stackAllocs[j] = &shared->getValue();
+			shared->getValue().allocSize += size;
+#ifdef LMT_PLATFORM_WINDOWS
+			if (name != TRUNCATED_STACK_NAME)
+				LMT_USE_FREE((void*)name);
+#endif
+			continue;
+		}
+
+		found->getValue().shared = &shared->getValue();
+		shared->getValue().str = name;
+		shared->getValue().allocSize = size;
+		shared->getValue().folded = isFolded(name, absoluteAddress);
+
+		stackAllocs[j] = &shared->getValue();
+		shared->getValue().next = g_allocList;
+		g_allocList = &shared->getValue();
+	}
+	allocStack.stackSize = chunk->allocStackSize[index];
+	if (g_foldRuleCount > 0)
+		allocStack.stackSize = foldStack(allocStack, allocStack.stackSize, size);
+	if (root)
+	{
+		// Root is inserted before the outermost frame,
+		// which is skipped by updateTree
+		const uint8_t last = allocStack.stackSize;
+		if (last > 0)
+		{
+			stackAllocs[last] = stackAllocs[last - 1];
+			stackAllocs[last - 1] = root;
+		}
+		else
+		{
+			stackAllocs[0] = root;
+		}
+		root->allocSize += size;
+		allocStack.stackSize += 1;
+#ifdef LMT_PEAK_ACTIVATED
+		allocStack.pooled = true;
+#endif
+	}
+#ifdef LMT_COLLAPSE_RECURSION
+	allocStack.stackSize = collapseRecursion(allocStack, allocStack.stackSize, size);
+#endif
+	// Frames removed by folding and collapsing are given back to the arena
+	g_stackArenaUsed -= reserved - allocStack.stackSize;
+	updateTree(allocStack, size, churn, true);
+	return allocStack;
+}
+
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+void LiveMemTracer::addSizeClass(AllocStack &allocStack, uint8_t sizeClass, uint32_t count)
+{
+	allocStack.sizeClasses[sizeClass] += count;
+	Alloc **stackAllocs = getStackAllocs(allocStack);
+	for (size_t j = 0; j < allocStack.stackSize; ++j)
+	{
+		stackAllocs[j]->sizeClasses[sizeClass] += count;
+	}
+}
+#endif
+
+// Treat the chunk of the calling thread now, without LMT_TREAT_CHUNK
+#ifdef LMT_LEAK_REPORT
+// Only the calling thread, chunks of other threads are written without lock
+void LiveMemTracer::flushCurrentChunk()
+{
+	Chunk *chunk = g_th_currentChunk;
+	if (chunk == nullptr || g_runningStatus != RunningStatus::RUNNING)
+		return;
+	if (chunk->status != ChunkStatus::TEMPORARY)
+		chunk->status = ChunkStatus::PENDING;
+	g_th_currentChunk = nullptr;
+	treatChunk(chunk);
+}
+#endif
+
+// Opened for writing, fopen is deprecated by the Windows CRT
+FILE *LiveMemTracer::openFile(const char *path)
+{
+#ifdef LMT_PLATFORM_WINDOWS
+	FILE *file = nullptr;
+	return fopen_s(&file, path, "w") == 0 ? file : nullptr;
+#else
+	return fopen(path, "w");
+#endif
+}
+
+bool LiveMemTracer::writeLeakReport(const char *path)
+{
+	INTERNAL_SCOPE;
+	FILE *file = path ? openFile(path) : stderr;
+	if (!file)
+		return false;
+	std::lock_guard<std::mutex> lock(g_mutex);
+	LMTVector<AllocStack*> stacks;
+	ptrdiff_t total = 0;
+	for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
+	{
+		if (stack->allocSize == 0)
+			continue;
+		stacks.push_back(stack);
+		total += stack->allocSize;
+	}
+	std::sort(stacks.begin(), stacks.end(), [](const AllocStack *a, const AllocStack *b){ return a->allocSize > b->allocSize; });
+
+	fprintf(file, "LiveMemTracer : %i stacks still hold %lld bytes\n", int(stacks.end() - stacks.begin()), (long long)total);
+	for (AllocStack *stack : stacks)
+	{
+#ifdef LMT_INSTANCE_COUNT_ACTIVATED
+		fprintf(file, "\n%lld bytes in %lld allocations\n", (long long)stack->allocSize, (long long)stack->instanceCount);
+#else
+		fprintf(file, "\n%lld bytes\n", (long long)stack->allocSize);
+#endif
+		if (stack->stackSize == 0)
+		{
+			fprintf(file, "    %s\n", UNKNOWN_STACK_NAME);
+			continue;
+		}
+		Alloc **stackAllocs = getStackAllocs(*stack);
+		for (uint8_t i = 0; i < stack->stackSize; ++i)
+		{
+			fprintf(file, "    %s\n", stackAllocs[i]->str);
+		}
+	}
+	fflush(file);
+	if (path)
+		fclose(file);
+	return true;
+}
+
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+// Same as pool events, the heap ID is used as pool.
+// Chunks of different threads are treated out of order, the allocation
+// timestamp (saved in free events too) tells which event is the most recent
+// one for an address, older ones are ignored.
+void LiveMemTracer::treatLiveEvent(const Chunk *chunk, size_t index)
+{
+	void *ptr = chunk->allocPtr[index];
+	const uint8_t heap = chunk->allocHeap[index];
+	const uint64_t time = chunk->allocTime[index];
+	const bool isFree = chunk->allocStackIndex[index] == size_t(-1);
+
+	auto entry = g_liveTable.find(ptr, heap);
+	if (!entry)
+	{
+		entry = g_liveTable.insert(ptr, heap);
+		if (!entry)
+			return;
+		if (isFree)
+		{
+			// Free is treated before its allocation
+			entry->freed = true;
+			entry->time = time;
+			++g_liveFreedCount;
+			return;
+		}
+	}
+	else if (entry->time > time)
+	{
+		// Address was reused by a more recent allocation
+		return;
+	}
+	else if (entry->time == time)
+	{
+		// Free of this allocation, or allocation of this early free
+		if (entry->freed)
+			--g_liveFreedCount;
+		g_liveTable.remove(entry);
+		return;
+	}
+	else
+	{
+		// Older allocation or early free whose counterpart was never treated
+		// (lost with a full table, or not tracked)
+		if (entry->freed)
+			--g_liveFreedCount;
+		entry->freed = isFree;
+		entry->time = time;
+		if (isFree)
+		{
+			++g_liveFreedCount;
+			return;
+		}
+	}
+	entry->size = size_t(chunk->allocSize[index]);
+	entry->stack = chunk->allocHash[index];
+	entry->time = time;
+}
+
+// g_mutex has to be locked
+bool LiveMemTracer::writeHeapDump(const char *path)
+{
+	INTERNAL_SCOPE;
+	FILE *file = openFile(path);
+	if (!file)
+		return false;
+	// Stacks first, then allocations referencing them by hash
+	fprintf(file, "stack,hash,size,frames\n");
+	for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
+	{
+		if (stack->allocSize == 0)
+			continue;
+		fprintf(file, "stack,%016llx,%lld,", (unsigned long long)stack->hash, (long long)stack->allocSize);
+		Alloc **stackAllocs = getStackAllocs(*stack);
+		for (uint8_t i = 0; i < stack->stackSize; ++i)
+		{
+			fprintf(file, i == 0 ? "%s" : ";%s", stackAllocs[i]->str);
+		}
+		fprintf(file, "\n");
+	}
+	fprintf(file, "alloc,ptr,size,time,stack,heap\n");
+	for (auto &e : g_liveTable)
+	{
+		if (e.ptr == nullptr || e.freed)
+			continue;
+		fprintf(file, "alloc,%p,%llu,%llu,%016llx,%i\n", e.ptr, (unsigned long long)e.size, (unsigned long long)e.time, (unsigned long long)e.stack, int(e.pool));
+	}
+	fclose(file);
+	return true;
+}
+#endif
+
+bool LiveMemTracer::dumpHeap(const char *path)
+{
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+	std::lock_guard<std::mutex> lock(g_mutex);
+	return writeHeapDump(path);
+#else
+	(void)path;
+	return false;
+#endif
+}
+
+uint32_t LiveMemTracer::mark()
+{
+#ifdef LMT_GENERATION_ACTIVATED
+	return g_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+#else
+	return 0;
+#endif
+}
+
+size_t LiveMemTracer::liveSinceMark(uint32_t generation)
+{
+#ifdef LMT_GENERATION_ACTIVATED
+	std::lock_guard<std::mutex> lock(g_mutex);
+	ptrdiff_t size = 0;
+	for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
+	{
+		size += getSizeSinceMark(*stack, generation);
+	}
+	return size > 0 ? size_t(size) : 0;
+#else
+	(void)generation;
+	return 0;
+#endif
+}
+
+#ifdef LMT_GENERATION_ACTIVATED
+void LiveMemTracer::addGeneration(AllocStack &allocStack, uint32_t generation, ptrdiff_t size)
+{
+	const size_t slot = generation % LMT_GENERATION_NUMBER;
+	if (allocStack.generations[slot] == generation)
+	{
+		allocStack.generationSizes[slot] += size;
+	}
+	else if (allocStack.generations[slot] < generation)
+	{
+		// The slot is reused, its generation is out of the ring
+		allocStack.oldGenerationSize += allocStack.generationSizes[slot];
+		allocStack.generations[slot] = generation;
+		allocStack.generationSizes[slot] = size;
+	}
+	else
+	{
+		allocStack.oldGenerationSize += size;
+	}
+}
+
+// Generations out of the ring are merged, if the asked one is one of them
+// all the old generations are counted
+ptrdiff_t LiveMemTracer::getSizeSinceMark(const AllocStack &allocStack, uint32_t generation)
+{
+	ptrdiff_t size = 0;
+	for (size_t i = 0; i < LMT_GENERATION_NUMBER; ++i)
+	{
+		if (allocStack.generations[i] >= generation)
+			size += allocStack.generationSizes[i];
+	}
+	if (generation + LMT_GENERATION_NUMBER <= g_generation.load(std::memory_order_relaxed))
+		size += allocStack.oldGenerationSize;
+	return size;
+}
+#endif
+
+void LiveMemTracer::frameMark()
+{
+#ifdef LMT_FRAME_ACTIVATED
+	g_frameIndex.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+void LiveMemTracer::setFrameBudget(size_t bytes)
+{
+#ifdef LMT_FRAME_ACTIVATED
+	std::lock_guard<std::mutex> lock(g_mutex);
+	g_frameBudget = bytes;
+#else
+	(void)bytes;
+#endif
+}
+
+#ifdef LMT_FRAME_ACTIVATED
+void LiveMemTracer::updateFrame(uint32_t frameIndex, AllocStack &allocStack, const Churn &churn)
+{
+	Frame &frame = g_frames[frameIndex % LMT_FRAME_HISTORY];
+	if (frame.index != frameIndex)
+	{
+		// Events of a frame already out of the ring are ignored
+		if (frameIndex < frame.index)
+			return;
+		memset(&frame, 0, sizeof(Frame));
+		frame.index = frameIndex;
+	}
+	frame.allocCount += uint32_t(churn.allocCount);
+	frame.freeCount += uint32_t(churn.freeCount);
+	frame.allocBytes += churn.allocBytes;
+	if (churn.allocBytes == 0)
+		return;
+	FrameStack *smallest = &frame.stacks[0];
+	for (size_t i = 0; i < LMT_FRAME_TOP_STACKS; ++i)
+	{
+		FrameStack &entry = frame.stacks[i];
+		if (entry.stack == &allocStack)
+		{
+			entry.allocBytes += churn.allocBytes;
+			return;
+		}
+		if (entry.allocBytes < smallest->allocBytes)
+			smallest = &entry;
+	}
+	if (smallest->allocBytes < churn.allocBytes)
+	{
+		smallest->stack = &allocStack;
+		smallest->allocBytes = churn.allocBytes;
+	}
+}
+#endif
+
+#ifdef LMT_PEAK_ACTIVATED
+// Chunks of different threads are treated in any order,
+// so the peak is the one seen at treatment time.
+// Only heap events, pools are usually carved from a heap allocation already counted.
+void LiveMemTracer::updatePeak(ptrdiff_t size)
+{
+	g_liveSize += size;
+	if (g_liveSize <= g_peakSize)
+		return;
+	g_peakSize = g_liveSize;
+	// Snapshot walks every stack, the margin grows with the peak
+	// so it's done a logarithmic number of times
+	const ptrdiff_t margin = std::max<ptrdiff_t>(LMT_PEAK_SNAPSHOT_MARGIN, g_peakSnapshot.allocSize / 8);
+	if (g_peakSize >= g_peakSnapshot.allocSize + margin)
+		takePeakSnapshot();
+}
+
+void LiveMemTracer::takePeakSnapshot()
+{
+	PeakSnapshot &snapshot = g_peakSnapshot;
+	snapshot.allocSize = g_peakSize;
+	snapshot.count = 0;
+	for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
+	{
+		if (stack->allocSize <= 0 || stack->pooled)
+			continue;
+		if (snapshot.count == LMT_PEAK_SNAPSHOT_SIZE && stack->allocSize <= snapshot.entries[snapshot.count - 1].allocSize)
+			continue;
+		// Entries are kept sorted, the smallest one is dropped when full
+		size_t i = snapshot.count < LMT_PEAK_SNAPSHOT_SIZE ? snapshot.count++ : snapshot.count - 1;
+		for (; i > 0 && snapshot.entries[i - 1].allocSize < stack->allocSize; --i)
+		{
+			snapshot.entries[i] = snapshot.entries[i - 1];
+		}
+		snapshot.entries[i].stack = stack;
+		snapshot.entries[i].allocSize = stack->allocSize;
+	}
+}
+
+void LiveMemTracer::resetPeak()
+{
+	g_peakSize = g_liveSize;
+	g_peakSnapshot.allocSize = 0;
+	g_peakSnapshot.count = 0;
+	for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
+	{
+		stack->peakSize = stack->allocSize;
+	}
+}
+#endif
+
+#ifdef LMT_LIFETIME_ACTIVATED
+void LiveMemTracer::addLifetime(AllocStack &allocStack, uint8_t bucket, uint32_t count, size_t bytes)
+{
+	allocStack.lifetimes[bucket] += count;
+	allocStack.lifetimeBytes[bucket] += bytes;
+}
+#endif
+
+bool LiveMemTracer::exportSizeClasses(const char *path)
+{
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+	INTERNAL_SCOPE;
+	FILE *file = openFile(path);
+	if (!file)
+		return false;
+	std::lock_guard<std::mutex> lock(g_mutex);
+	fprintf(file, "Stack,Function,Size");
+	for (uint8_t i = 0; i < SIZE_CLASS_NUMBER; ++i)
+	{
+		fprintf(file, ",%llu", 1ULL << i);
+	}
+	fprintf(file, "\n");
+	for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
+	{
+		if (stack->stackSize == 0)
+			continue;
+		fprintf(file, "%016llx,\"", (unsigned long long)stack->hash);
+		for (const char *c = getStackAllocs(*stack)[0]->str; *c != '\0'; ++c)
+		{
+			if (*c == '"')
+				fputc('"', file);
+			fputc(*c, file);
+		}
+		fprintf(file, "\",%lld", (long long)stack->allocSize);
+		for (uint8_t i = 0; i < SIZE_CLASS_NUMBER; ++i)
+		{
+			fprintf(file, ",%u", stack->sizeClasses[i]);
+		}
+		fprintf(file, "\n");
+	}
+	fclose(file);
+	return true;
+#else
+	(void)path;
+	return false;
+#endif
+}
+
+uint32_t LiveMemTracer::allocateStackFrames(uint32_t count)
+{
+	if (g_stackArenaChunkCount == 0 || g_stackArenaUsed + count > LMT_STACK_ARENA_CHUNK_SIZE)
+	{
+		LMT_ASSERT(g_stackArenaChunkCount < STACK_ARENA_CHUNK_NUMBER, "Stack arena is full, increase LMT_STACK_ARENA_CHUNK_SIZE");
+		if (g_stackArenaChunkCount >= STACK_ARENA_CHUNK_NUMBER)
+			return uint32_t(-1);
+		Alloc **arenaChunk = (Alloc**)internalAlloc(sizeof(Alloc*) * (LMT_STACK_ARENA_CHUNK_SIZE));
+		if (arenaChunk == nullptr)
+			return uint32_t(-1);
+		g_stackArenaChunks[g_stackArenaChunkCount++] = arenaChunk;
+		g_stackArenaUsed = 0;
+	}
+	const uint32_t offset = (g_stackArenaChunkCount - 1) * (LMT_STACK_ARENA_CHUNK_SIZE) + g_stackArenaUsed;
+	g_stackArenaUsed += count;
+	return offset;
+}
+
+LMT_INLINE LiveMemTracer::Alloc **LiveMemTracer::getStackAllocs(const AllocStack &allocStack)
+{
+	return &g_stackArenaChunks[allocStack.stackOffset / (LMT_STACK_ARENA_CHUNK_SIZE)][allocStack.stackOffset % (LMT_STACK_ARENA_CHUNK_SIZE)];
+}
+
+bool LiveMemTracer::isFolded(const char *name, void *address)
+{
+	for (uint8_t i = 0; i < g_foldRuleCount; ++i)
+	{
+		const FoldRule &rule = g_foldRules[i];
+		if (rule.prefix != nullptr)
+		{
+			if (strncmp(name, rule.prefix, rule.prefixLength) == 0)
+				return true;
+		}
+		else if (uintptr_t(address) >= rule.begin && uintptr_t(address) < rule.end)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Called once when a stack is created, folded frames are removed from it
+// so that updateTree never visit them. The outermost frame is always kept.
+// A run of folded frames is collapsed into its outermost frame (the entry point
+// into folded code), or entirely dropped with LMT_FOLD_DROP.
+uint8_t LiveMemTracer::foldStack(AllocStack &allocStack, uint8_t stackSize, ptrdiff_t size)
+{
+	Alloc **stackAllocs = getStackAllocs(allocStack);
+	uint8_t count = 0;
+	for (uint8_t j = 0; j < stackSize; ++j)
+	{
+		Alloc *alloc = stackAllocs[j];
+		const bool outermost = j + 1 == stackSize;
+#ifdef LMT_FOLD_DROP
+		const bool keep = !alloc->folded || outermost;
+#else
+		const bool keep = !alloc->folded || outermost || !stackAllocs[j + 1]->folded;
+#endif
+		if (!keep)
+		{
+			alloc->allocSize -= size;
+			continue;
+		}
+		stackAllocs[count++] = alloc;
+	}
+	return count;
+}
+
+#ifdef LMT_COLLAPSE_RECURSION
+// Consecutive frames of the same function are merged into one,
+// the number of merged frames is kept to be reported by the edge.
+uint8_t LiveMemTracer::collapseRecursion(AllocStack &allocStack, uint8_t stackSize, ptrdiff_t size)
+{
+	allocStack.recursions.resize(stackSize);
+	Alloc **stackAllocs = getStackAllocs(allocStack);
+	uint8_t count = 0;
+	for (uint8_t j = 0; j < stackSize; ++j)
+	{
+		Alloc *alloc = stackAllocs[j];
+		if (count > 0 && stackAllocs[count - 1] == alloc)
+		{
+			alloc->allocSize -= size;
+			allocStack.recursions[count - 1] += 1;
+			continue;
+		}
+		stackAllocs[count] = alloc;
+		allocStack.recursions[count] = 1;
+		++count;
+	}
+	return count;
+}
+#endif
+
+LiveMemTracer::Alloc *LiveMemTracer::getPoolRoot(uint8_t pool)
+{
+	Pool &p = g_pools[pool];
+	if (p.root)
+		return p.root;
+	if (p.rootName[0] == 0 && pool < LMT_POOL_NUMBER)
+		LMT_SNPRINTF(p.rootName, sizeof(p.rootName), "[Pool] %i", int(pool));
+	else if (p.rootName[0] == 0)
+		LMT_SNPRINTF(p.rootName, sizeof(p.rootName), "[Resource] %i", int(pool - LMT_POOL_NUMBER));
+	p.root = &p.rootAlloc;
+	p.root->str = p.rootName;
+	p.root->next = g_allocList;
+	g_allocList = p.root;
+	return p.root;
+}
+
+// Chunks of different threads are treated in any order, events are matched
+// with their sequence : a free releases the allocation logged before it
+void LiveMemTracer::treatPoolEvent(Chunk *chunk, size_t index)
+{
+	const uint8_t pool = chunk->allocPool[index] - 1;
+	void *ptr = chunk->allocPtr[index];
+	const uint64_t sequence = chunk->allocTime[index];
+	Pool &p = g_pools[pool];
+
+	if (chunk->allocStackIndex[index] == size_t(-1))
+	{
+		auto entry = g_poolTable.find(ptr, pool);
+		if (!entry)
+		{
+			// Free is treated before its allocation,
+			// the allocation will cancel it.
+			entry = g_poolTable.insert(ptr, pool);
+			if (entry)
+			{
+				entry->freed = true;
+				entry->time = sequence;
+			}
+			return;
+		}
+		if (entry->time > sequence)
+		{
+			// Free of an older allocation, already released
+			// when the pointer was re-used
+			return;
+		}
+		if (entry->freed)
+		{
+			// Allocation between the two frees was never treated
+			entry->time = sequence;
+			return;
+		}
+		const ptrdiff_t size = ptrdiff_t(entry->size);
+		const Hash hash = entry->stack;
+		g_poolTable.remove(entry);
+		p.allocSize -= size;
+		p.count -= 1;
+		updateStack(chunk, index, hash, -size, getChurn(chunk, index), getPoolRoot(pool));
+		return;
+	}
+
+	auto entry = g_poolTable.insert(ptr, pool);
+	if (!entry)
+		return;
+	if (entry->freed)
+	{
+		if (entry->time > sequence)
+		{
+			// Early free of this allocation
+			g_poolTable.remove(entry);
+			return;
+		}
+		// Free of an allocation that was never treated
+		entry->freed = false;
+	}
+	else if (entry->time > sequence)
+	{
+		// Pointer already re-used by a more recent allocation,
+		// this one was released before
+		return;
+	}
+	else if (entry->size != 0 || entry->stack != 0)
+	{
+		// Pointer re-used before its free was treated, old allocation is released
+		p.allocSize -= ptrdiff_t(entry->size);
+		p.count -= 1;
+		updateStack(chunk, index, entry->stack, -ptrdiff_t(entry->size), makeChurn(0, 0, 1), getPoolRoot(pool));
+	}
+	const ptrdiff_t size = chunk->allocSize[index];
+	entry->size = size_t(size);
+	entry->stack = chunk->allocHash[index];
+	entry->time = sequence;
+	p.allocSize += size;
+	p.count += 1;
+	if (p.allocSize > p.peakSize)
+		p.peakSize = p.allocSize;
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+	addSizeClass(updateStack(chunk, index, chunk->allocHash[index], size, getChurn(chunk, index), getPoolRoot(pool)), getSizeClass(size_t(size)), 1);
+#else
+	updateStack(chunk, index, chunk->allocHash[index], size, getChurn(chunk, index), getPoolRoot(pool));
+#endif
+}
+
+void LiveMemTracer::updateTree(AllocStack &allocStack, ptrdiff_t size, const Churn &churn, bool checkTree)
+{
+	Alloc **stackAllocs = getStackAllocs(allocStack);
+	int stackSize = allocStack.stackSize;
+	stackSize -= INTERNAL_FRAME_TO_SKIP;
+	uint8_t depth = 0;
+	EdgeIndex previous = EDGE_NONE;
+	while (stackSize >= 0)
+	{
+		Hash currentHash = LMT_HASH_FROM_PTR(stackAllocs[stackSize]);
+		currentHash = combineHash(size_t(previous), currentHash);
+		currentHash = combineHash(depth * depth, currentHash);
+
+		TreeKey key(currentHash, LMT_HASH_FROM_PTR(stackAllocs[stackSize]->str));
+
+		auto pair = g_treeDictionary.update(key);
+		EdgeIndex &current = pair->getValue();
+		if (current == EDGE_NONE)
+		{
+			current = createEdge();
+		}
+		if (current == EDGE_NONE)
+		{
+			// Tree is full, deeper frames can't be linked to their parent
+			++g_truncatedTreeStacks;
+			return;
+		}
+		g_edgeSizes[current] += size;
+		LMT_INC_INSTANCE(g_edgeInstanceCounts[current], size);
+#ifdef LMT_CHURN_ACTIVATED
+		addChurn(g_edgeChurns[current], churn);
+#else
+		(void)churn;
+#endif
+		if (checkTree)
+		{
+			Edge &edge = g_edges[current];
+			if (!edge.alloc)
+			{
+				LMT_DEBUG_ASSERT(edge.same == EDGE_NONE, "Edge already have a same pointer defined.");
+				edge.alloc = stackAllocs[stackSize];
+				edge.same = stackAllocs[stackSize]->edges;
+				stackAllocs[stackSize]->edges = current;
+
+				// The tree key contains the parent, so the tree dictionary is the
+				// child lookup : a new edge is never already linked to its parent.
+				EdgeIndex &firstChild = previous != EDGE_NONE ? g_edges[previous].firstChild : g_firstRoot;
+				edge.nextSibling = firstChild;
+				firstChild = current;
+				edge.from = previous;
+				edge.depth = depth;
+			}
+#ifdef LMT_COLLAPSE_RECURSION
+			if (allocStack.recursions[stackSize] > edge.recursion)
+				edge.recursion = allocStack.recursions[stackSize];
+#endif
+		}
+		LMT_DEBUG_ASSERT(strcmp(g_edges[current].alloc->str, stackAllocs[stackSize]->str) == 0, "Name collision.");
+
+		previous = current;
+		++depth;
+		--stackSize;
+	}
+}
+
+LiveMemTracer::EdgeIndex LiveMemTracer::createEdge()
+{
+	LMT_DEBUG_ASSERT(g_edgeCount <= LMT_TREE_DICTIONARY_SIZE, "LMT : Tree is full.");
+	if (g_edgeCount > LMT_TREE_DICTIONARY_SIZE)
+		return EDGE_NONE;
+	const EdgeIndex index = g_edgeCount++;
+	Edge &edge = g_edges[index];
+	edge.allocSizeCache = 0;
+#ifdef LMT_CAPTURE_ACTIVATED
+	edge.allocSizeCapture = 0;
+#endif
+	edge.alloc = nullptr;
+	edge.from = EDGE_NONE;
+	edge.firstChild = EDGE_NONE;
+	edge.nextSibling = EDGE_NONE;
+	edge.same = EDGE_NONE;
+	edge.depth = 0;
+#ifdef LMT_COLLAPSE_RECURSION
+	edge.recursion = 1;
+#endif
+	return index;
+}
+
+template <class T>
+LMT_INLINE LiveMemTracer::Hash LiveMemTracer::combineHash(const T& val, const LiveMemTracer::Hash baseHash)
+{
+	// Word at a time, each word is mixed with the murmur3 64 bits finalizer
+	const uint8_t* bytes = (uint8_t*)&val;
+	const size_t count = sizeof(val);
+
+	Hash hash = baseHash;
+	for (size_t i = 0; i < count; i += sizeof(Hash))
+	{
+		Hash word = 0;
+		memcpy(&word, bytes + i, count - i < sizeof(Hash) ? count - i : sizeof(Hash));
+		hash ^= word + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ULL;
+		hash ^= hash >> 33;
+	}
+	return hash;
+}
+
+LMT_INLINE LiveMemTracer::Hash LiveMemTracer::hashCallstack(void **stack, uint32_t count)
+{
+	Hash hash = 14695981039346656037ULL;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		hash = combineHash(stack[i], hash);
+	}
+	return hash;
+}
+
+#if LMT_IMGUI
+#include LMT_IMGUI_INCLUDE_PATH
+
+namespace LiveMemTracer
+{
+	namespace Renderer
+	{
+		static bool SortGroupedEdge(const GroupedEdge &a, const GroupedEdge &b)
+		{
+			return a.allocSize > b.allocSize;
+		}
+
+		static bool InsertSortedEdge(const GroupedEdge &a, const GroupedEdge &b)
+		{
 			return a.alloc < b.alloc;
 		}
 
-		float formatMemoryString(ptrdiff_t sizeInBytes, const char *&str)
+		float formatMemoryString(ptrdiff_t sizeInBytes, const char *&str)
+		{
+			float multiplier = 1.f;
+			if (sizeInBytes < 0)
+			{
+				multiplier = -1.f;
+				sizeInBytes *= -1;
+			}
+			if (sizeInBytes < 10 * 1024)
+			{
+				str = "B";
+				return float(sizeInBytes) * multiplier;
+			}
+			else if (sizeInBytes < 10 * 1024 * 1024)
+			{
+				str = "KiB";
+				return sizeInBytes / 1024.f * multiplier;
+			}
+			else
+			{
+				str = "Mb";
+				return sizeInBytes / 1024 / 1024.f * multiplier;
+			}
+		}
+
+		bool searchAlloc()
+		{
+			Alloc *alloc = g_allocList;
+
+			Alloc **prevNext = &g_allocList;
+			g_searchResult = nullptr;
+
+			while (alloc != nullptr)
+			{
+				Alloc *next = alloc->next;
+				if (LMT_STRSTRI(alloc->str, g_searchStr) != nullptr)
+				{
+					*prevNext = alloc->next;
+					alloc->next = g_searchResult;
+					g_searchResult = alloc;
+				}
+				else
+				{
+					prevNext = &alloc->next;
+				}
+				alloc = next;
+			}
+
+			bool hasChanged = true;
+			while (g_searchResult && hasChanged)
+			{
+				hasChanged = false;
+				Alloc **pv = &g_searchResult;
+				Alloc *nd = g_searchResult;
+				nd->allocSizeCache = nd->allocSize;
+				Alloc *nx = g_searchResult->next;
+
+				while (nx)
+				{
+					nx->allocSizeCache = nx->allocSize;
+					if (nd->allocSizeCache < nx->allocSizeCache)
+					{
+						nd->next = nx->next;
+						nx->next = nd;
+						*pv = nx;
+
+						hasChanged = true;
+					}
+					pv = &nd->next;
+					nd = nx;
+					nx = nx->next;
+				}
+			}
+			*prevNext = g_searchResult;
+
+			return g_searchResult != nullptr;
+		}
+
+		void displayCallerTooltip(EdgeIndex from, size_t &depth)
+		{
+			if (from == EDGE_NONE)
+				return;
+			size_t depthCopy = depth;
+			displayCallerTooltip(g_edges[from].from, ++depth);
+			if (g_edges[from].from != EDGE_NONE)
+				ImGui::Indent();
+			ImGui::Text(g_edges[from].alloc->str);
+			if (depthCopy == 0)
+			{
+				while (depth - 1 > 0)
+				{
+					ImGui::Unindent();
+					--depth;
+				}
+			}
+		}
+
+		// Stable merge sort of a list of siblings, biggest first
+		EdgeIndex sortSiblings(EdgeIndex head)
+		{
+			if (head == EDGE_NONE || g_edges[head].nextSibling == EDGE_NONE)
+				return head;
+			EdgeIndex slow = head;
+			EdgeIndex fast = g_edges[head].nextSibling;
+			while (fast != EDGE_NONE && g_edges[fast].nextSibling != EDGE_NONE)
+			{
+				slow = g_edges[slow].nextSibling;
+				fast = g_edges[g_edges[fast].nextSibling].nextSibling;
+			}
+			EdgeIndex a = head;
+			EdgeIndex b = g_edges[slow].nextSibling;
+			g_edges[slow].nextSibling = EDGE_NONE;
+			a = sortSiblings(a);
+			b = sortSiblings(b);
+			EdgeIndex result = EDGE_NONE;
+			EdgeIndex *tail = &result;
+			while (a != EDGE_NONE && b != EDGE_NONE)
+			{
+				if (g_edges[b].allocSizeCache > g_edges[a].allocSizeCache)
+				{
+					*tail = b;
+					b = g_edges[b].nextSibling;
+				}
+				else
+				{
+					*tail = a;
+					a = g_edges[a].nextSibling;
+				}
+				tail = &g_edges[*tail].nextSibling;
+			}
+			*tail = a != EDGE_NONE ? a : b;
+			return result;
+		}
+
+#define PAD_AND_SET_IMGUI_CURSOR(cursor, pad) cursor.x += pad; ImGui::SetCursorPos(cursor)
+
+		void renderCallee(EdgeIndex index, bool callerTooltip)
 		{
-			float multiplier = 1.f;
-			if (sizeInBytes < 0)
+			if (index == EDGE_NONE)
+				return;
+
+			Edge *callee = &g_edges[index];
+			ImGui::PushID(callee);
+			const char *suffix;
+			if (g_updateType != UpdateType::NONE)
 			{
-				multiplier = -1.f;
-				sizeInBytes *= -1;
+				callee->allocSizeCache = g_edgeSizes[index];
 			}
-			if (sizeInBytes < 10 * 1024)
+			float size = formatMemoryString(callee->allocSizeCache, suffix);
+			auto cursorPos = ImGui::GetCursorPos();
+			const bool opened = ImGui::TreeNode(callee, "%4.0f %s", size, suffix);
+#ifdef LMT_INSTANCE_COUNT_ACTIVATED
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("%4i", int(g_edgeInstanceCounts[index]));
+#endif
+#ifdef LMT_CHURN_ACTIVATED
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("%8llu", (unsigned long long)g_edgeChurns[index].allocCount);
+#endif
+#ifdef LMT_CAPTURE_ACTIVATED
+			ptrdiff_t diff = callee->allocSizeCache - callee->allocSizeCapture;
+			size = formatMemoryString(diff, suffix);
+			const char *capturedSuffix;
+			float capturedSize = formatMemoryString(callee->allocSizeCapture, capturedSuffix);
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			if (diff > 0)
 			{
-				str = "B";
-				return float(sizeInBytes) * multiplier;
+				ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "%4.0f %s", size, suffix);
 			}
-			else if (sizeInBytes < 10 * 1024 * 1024)
+			else
+			{
+				ImGui::TextColored(ImVec4(0.f, 1.f, 0.f, 1.f), "%4.0f %s", size, suffix);
+			}
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("[%4.0f %s]", capturedSize, capturedSuffix);
+#endif
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("%s", callee->alloc->str);
+			if (callerTooltip && ImGui::IsItemHovered())
+			{
+				ImGui::BeginTooltip();
+				size_t depth;
+				displayCallerTooltip(callee->from, depth);
+				ImGui::EndTooltip();
+			}
+			if (ImGui::BeginPopupContextItem("Options"))
+			{
+				if (ImGui::Selectable("Watch call"))
+				{
+					createHistogram(index);
+				}
+				if (ImGui::Selectable("Watch function"))
+				{
+					createHistogram(callee->alloc);
+					g_displayType = DisplayType::HISTOGRAMS;
+				}
+				if (ImGui::Selectable("Function view"))
+				{
+					g_functionView = callee->alloc;
+					g_displayType = DisplayType::FUNCTION;
+					g_updateType = UpdateType::CURRENT_AND_NEXT_FRAME;
+				}
+				ImGui::EndPopup();
+			}
+#ifdef LMT_COLLAPSE_RECURSION
+			if (callee->recursion > 1)
+			{
+				ImGui::SameLine();
+				ImGui::TextDisabled("(recursive x%i)", int(callee->recursion));
+			}
+#endif
+			if (opened)
+			{
+				if (g_updateType != UpdateType::NONE || g_refeshAuto == false)
+				{
+					callee->firstChild = sortSiblings(callee->firstChild);
+				}
+				for (EdgeIndex to = callee->firstChild; to != EDGE_NONE; to = g_edges[to].nextSibling)
+				{
+					renderCallee(to, callerTooltip);
+				}
+				ImGui::TreePop();
+			}
+			ImGui::PopID();
+		}
+
+		void renderCallees()
+		{
+			ImGui::Separator();
+			ImVec2 cursorPos = ImGui::GetCursorPos();
+			ImGui::Text("Size");
+#ifdef LMT_INSTANCE_COUNT_ACTIVATED
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Count");
+#endif
+#ifdef LMT_CHURN_ACTIVATED
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Allocs");
+#endif
+#ifdef LMT_CAPTURE_ACTIVATED
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Diff");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Captured");
+#endif
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Callee");
+			ImGui::Separator();
+			ImGui::BeginChild("Content", ImGui::GetWindowContentRegionMax(), false, ImGuiWindowFlags_HorizontalScrollbar);
+			Alloc *callee = g_searchResult;
+			int i = 0;
+			while (callee)
+			{
+				if (callee->edges == EDGE_NONE)
+				{
+					callee = callee->next;
+					continue;
+				}
+
+				ImGui::PushID(callee);
+				++i;
+				auto cursorPos = ImGui::GetCursorPos();
+				if (i % 2)
+				{
+					ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.4f, 0.4f, 0.78f, 0.45f));
+					ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.4f, 0.4f, 0.78f, 0.65f));
+					ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.4f, 0.4f, 0.78f, 0.85f));
+				}
+				else
+				{
+					ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.4f, 0.57f, 0.78f, 0.45f));
+					ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.4f, 0.57f, 0.78f, 0.65f));
+					ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.4f, 0.57f, 0.78f, 0.85f));
+				}
+				bool opened = ImGui::CollapsingHeader("##dummy", "NoName", true, false);
+				if (ImGui::BeginPopupContextItem("Options"))
+				{
+					if (ImGui::Selectable("Watch function"))
+					{
+						createHistogram(callee);
+						g_displayType = DisplayType::HISTOGRAMS;
+					}
+					if (ImGui::Selectable("Function view"))
+					{
+						g_functionView = callee;
+						g_displayType = DisplayType::FUNCTION;
+						g_updateType = UpdateType::CURRENT_AND_NEXT_FRAME;
+					}
+					ImGui::EndPopup();
+				}
+
+				cursorPos.x += 20;
+				cursorPos.y += 3;
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 0);
+				const char *suffix;
+				float size = formatMemoryString(callee->allocSizeCache, suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				float nextPad = 80.f;
+#ifdef LMT_INSTANCE_COUNT_ACTIVATED
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, nextPad);
+				nextPad = 100.f;
+#endif
+#ifdef LMT_CAPTURE_ACTIVATED
+				ptrdiff_t diff = callee->allocSizeCache - callee->allocSizeCapture;
+				size = formatMemoryString(diff, suffix);
+				const char *capturedSuffix;
+				float capturedSize = formatMemoryString(callee->allocSizeCapture, capturedSuffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, nextPad);
+				if (diff > 0)
+				{
+					ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "%4.0f %s", size, suffix);
+				}
+				else
+				{
+					ImGui::TextColored(ImVec4(0.f, 1.f, 0.f, 1.f), "%4.0f %s", size, suffix);
+				}
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				ImGui::Text("[%4.0f %s]", capturedSize, capturedSuffix);
+#endif
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				ImGui::Text("%s", callee->str);
+				if (opened)
+				{
+					g_sortedEdges.clear();
+					EdgeIndex edge = callee->edges;
+					while (edge != EDGE_NONE)
+					{
+						auto it = std::lower_bound(g_sortedEdges.begin(), g_sortedEdges.end(), edge, [](EdgeIndex a, EdgeIndex b){ return g_edges[a].allocSizeCache > g_edges[b].allocSizeCache; });
+						if (it == g_sortedEdges.end() || *it != edge)
+						{
+							g_sortedEdges.insert(it, edge);
+						}
+						edge = g_edges[edge].same;
+					}
+					for (auto &e : g_sortedEdges)
+					{
+						renderCallee(e, true);
+					}
+				}
+				ImGui::PopID();
+				ImGui::PopStyleColor(3);
+				callee = callee->next;
+			}
+			ImGui::EndChild();
+		}
+
+		void renderFunctionView()
+		{
+			if (!g_functionView)
+				return;
+			ImGui::Columns(3);
+
+			//////////////////////////////////////////////////////////////////////////
+			// CALLERS
+			EdgeIndex index = g_functionView->edges;
+			size_t total = 0;
+			g_groupedEdges.clear();
+
+			while (index != EDGE_NONE)
+			{
+				Edge *edge = &g_edges[index];
+				if (edge->from != EDGE_NONE)
+				{
+					GroupedEdge group;
+					if (g_updateType != UpdateType::NONE)
+					{
+						edge->allocSizeCache = g_edgeSizes[index];
+					}
+					group.alloc = g_edges[edge->from].alloc;
+					group.allocSize = 0;
+
+					auto it = std::lower_bound(g_groupedEdges.begin(), g_groupedEdges.end(), group, InsertSortedEdge);
+					if (it == g_groupedEdges.end() || it->alloc != group.alloc)
+					{
+						it = g_groupedEdges.insert(it, group);
+					}
+					total += edge->allocSizeCache;
+					it->allocSize += edge->allocSizeCache;
+				}
+				index = edge->same;
+			}
+
+			std::stable_sort(g_groupedEdges.begin(), g_groupedEdges.end(), SortGroupedEdge);
+
+			for (auto &caller : g_groupedEdges)
+			{
+				ImVec2 cursorPos = ImGui::GetCursorScreenPos();
+				const char *suffix;
+				float size = formatMemoryString(caller.allocSize, suffix);
+				ImGui::TextWrapped("%s\n%4.0f%s", caller.alloc->str, size, suffix);
+				ImVec2 cursorPosNext = ImGui::GetCursorScreenPos();
+				ImGui::SetCursorScreenPos(cursorPos);
+				ImGui::PushID(caller.alloc);
+				if (ImGui::InvisibleButton("##Finvisible", ImVec2(ImGui::GetColumnWidth(), cursorPosNext.y - cursorPos.y)))
+				{
+					g_functionView = caller.alloc;
+					g_updateType = UpdateType::CURRENT_AND_NEXT_FRAME;
+				}
+				if (ImGui::BeginPopupContextItem("Options"))
+				{
+					if (ImGui::Selectable("Watch function"))
+					{
+						createHistogram(caller.alloc);
+						g_displayType = DisplayType::HISTOGRAMS;
+					}
+					ImGui::EndPopup();
+				}
+				ImGui::PopID();
+				ImGui::GetWindowDrawList()->AddRectFilled(cursorPos, ImVec2(cursorPos.x + float(caller.allocSize) / total * ImGui::GetColumnWidth(), ImGui::GetCursorScreenPos().y), 0x3F025CAB);
+			}
+
+			//////////////////////////////////////////////////////////////////////////
+			// FUNCTION
+			ImGui::NextColumn();
+
+			const char *suffix;
+			if (g_updateType != UpdateType::NONE)
 			{
-				str = "KiB";
-				return sizeInBytes / 1024.f * multiplier;
+				g_functionView->allocSizeCache = g_functionView->allocSize;
 			}
-			else
+			float size = formatMemoryString(g_functionView->allocSizeCache, suffix);
+			ImGui::TextWrapped("%s\n%4.0f%s", g_functionView->str, size, suffix);
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+			renderSizeClasses(g_functionView->sizeClasses);
+#endif
+			ImGui::PushID(g_functionView);
+			if (ImGui::BeginPopupContextItem("Options"))
 			{
-				str = "Mb";
-				return sizeInBytes / 1024 / 1024.f * multiplier;
+				if (ImGui::Selectable("Watch function"))
+				{
+					createHistogram(g_functionView);
+					g_displayType = DisplayType::HISTOGRAMS;
+				}
+				ImGui::EndPopup();
 			}
-		}
+			ImGui::PopID();
 
-		bool searchAlloc()
-		{
-			Alloc *alloc = g_allocList;
+			//////////////////////////////////////////////////////////////////////////
+			// CALLEE
+			ImGui::NextColumn();
 
-			Alloc **prevNext = &g_allocList;
-			g_searchResult = nullptr;
+			index = g_functionView->edges;
+			g_groupedEdges.clear();
+			total = 0;
 
-			while (alloc != nullptr)
+			while (index != EDGE_NONE)
 			{
-				Alloc *next = alloc->next;
-				if (LMT_STRSTRI(alloc->str, g_searchStr) != nullptr)
-				{
-					*prevNext = alloc->next;
-					alloc->next = g_searchResult;
-					g_searchResult = alloc;
-				}
-				else
+				for (EdgeIndex child = g_edges[index].firstChild; child != EDGE_NONE; child = g_edges[child].nextSibling)
 				{
-					prevNext = &alloc->next;
+					Edge *to = &g_edges[child];
+					GroupedEdge group;
+					if (g_updateType != UpdateType::NONE)
+					{
+						to->allocSizeCache = g_edgeSizes[child];
+					}
+					group.alloc = to->alloc;
+					group.allocSize = 0;
+
+					auto it = std::lower_bound(g_groupedEdges.begin(), g_groupedEdges.end(), group, InsertSortedEdge);
+					if (it == g_groupedEdges.end() || it->alloc != group.alloc)
+					{
+						it = g_groupedEdges.insert(it, group);
+					}
+
+					it->allocSize += to->allocSizeCache;
+					total += to->allocSizeCache;
 				}
-				alloc = next;
+				index = g_edges[index].same;
 			}
 
-			bool hasChanged = true;
-			while (g_searchResult && hasChanged)
-			{
-				hasChanged = false;
-				Alloc **pv = &g_searchResult;
-				Alloc *nd = g_searchResult;
-				nd->allocSizeCache = nd->allocSize;
-				Alloc *nx = g_searchResult->next;
+			std::stable_sort(g_groupedEdges.begin(), g_groupedEdges.end(), SortGroupedEdge);
 
-				while (nx)
+			for (auto &callee : g_groupedEdges)
+			{
+				ImVec2 cursorPos = ImGui::GetCursorScreenPos();
+				const char *suffix;
+				float size = formatMemoryString(callee.allocSize, suffix);
+				ImGui::TextWrapped("%s\n%4.0f%s", callee.alloc->str, size, suffix);
+				ImVec2 cursorPosNext = ImGui::GetCursorScreenPos();
+				ImGui::SetCursorScreenPos(cursorPos);
+				ImGui::PushID(callee.alloc);
+				if (ImGui::InvisibleButton("##invisible", ImVec2(ImGui::GetColumnWidth(), cursorPosNext.y - cursorPos.y)))
 				{
-					nx->allocSizeCache = nx->allocSize;
-					if (nd->allocSizeCache < nx->allocSizeCache)
+					g_functionView = callee.alloc;
+					g_updateType = UpdateType::CURRENT_AND_NEXT_FRAME;
+				}
+				if (ImGui::BeginPopupContextItem("Options"))
+				{
+					if (ImGui::Selectable("Watch function"))
 					{
-						nd->next = nx->next;
-						nx->next = nd;
-						*pv = nx;
-
-						hasChanged = true;
+						createHistogram(callee.alloc);
+						g_displayType = DisplayType::HISTOGRAMS;
 					}
-					pv = &nd->next;
-					nd = nx;
-					nx = nx->next;
+					ImGui::EndPopup();
 				}
+				ImGui::PopID();
+				ImGui::GetWindowDrawList()->AddRectFilled(cursorPos, ImVec2(cursorPos.x + float(callee.allocSize) / total * ImGui::GetColumnWidth(), ImGui::GetCursorScreenPos().y), 0x3F025CAB);
 			}
-			*prevNext = g_searchResult;
 
-			return g_searchResult != nullptr;
+			ImGui::Columns(1);
 		}
 
-		void displayCallerTooltip(Edge *from, size_t &depth)
+		void renderHistograms()
 		{
-			if (!from)
-				return;
-			size_t depthCopy = depth;
-			displayCallerTooltip(from->from, ++depth);
-			if (from->from)
-				ImGui::Indent();
-			ImGui::Text(from->alloc->str);
-			if (depthCopy == 0)
+			const int columnNumber = 3;
+			int i = 0;
+			float histoW = ImGui::GetWindowContentRegionWidth() / columnNumber;
+			ImVec2 graphSize(histoW, histoW * 0.4f);
+			auto it = g_histograms.begin();
+			while (it != g_histograms.end())
 			{
-				while (depth - 1 > 0)
+				auto &h = *it;
+
+				bool toDelete = false;
+				ImGui::PushID(i);
+				ImGui::PushItemWidth(histoW);
+				ImGui::BeginGroup();
+				ImGui::BeginGroup();
+				ImGui::TextColored(h.isFunction ? ImColor(217, 164, 22) : ImColor(209, 6, 145), "%s", h.isFunction ? "Function" : "Call"); ImGui::SameLine();
+				const char *suffix;
+				float size = formatMemoryString(h.allocSizeCache, suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				if (h.isFunction == false)
 				{
-					ImGui::Unindent();
-					--depth;
+					ImGui::SameLine();
+					ImGui::TextDisabled("(?)");
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::BeginTooltip();
+						size_t depth;
+						displayCallerTooltip(g_edges[h.call].from, depth);
+						ImGui::EndTooltip();
+					}
+				}
+				ImGui::Text("%.*s", int(histoW * 0.145f), h.name);
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip(h.name);
+				}
+				ImVec2 cursorPos = ImGui::GetCursorPos();
+				ImGui::PlotLines("##NoName", (const float*)h.allocSize, HISTORY_FRAME_NUMBER, h.cursor, nullptr, 0, FLT_MAX, graphSize, sizeof(ptrdiff_t));
+				ImGui::SetCursorPos(cursorPos);
+				ImGui::InvisibleButton("##invisibleButton", graphSize);
+				if (ImGui::IsItemHovered())
+				{
+					ImVec2 itemMin = ImGui::GetItemRectMin();
+					ImGuiIO& g = ImGui::GetIO();
+					const float x = (graphSize.x - (g.MousePos.x - itemMin.x)) / graphSize.x;
+					const int itemCount = HISTORY_FRAME_NUMBER;
+					const int id = itemCount - (int)(x * itemCount);
+					const int itemIndex = (id + h.cursor) % itemCount;
+
+					ImGui::SetTooltip("");
+					ImGui::BeginTooltip();
+					const char *ttSuffix;
+					float ttSize = formatMemoryString(h.allocSize[itemIndex], ttSuffix);
+					ImGui::Text("%4.0f %s", ttSize, ttSuffix);
+					ImGui::EndTooltip();
+				}
+				ImGui::EndGroup();
+				if (ImGui::BeginPopupContextItem("Options"))
+				{
+					toDelete = ImGui::Selectable("Delete");
+					ImGui::EndPopup();
+				}
+				ImGui::EndGroup();
+				ImGui::PopItemWidth();
+				ImGui::PopID();
+				if ((i % columnNumber) < columnNumber - 1)
+					ImGui::SameLine();
+				else
+					ImGui::Separator();
+				if (toDelete)
+				{
+					Histogram *last = g_histograms.end();
+					*it = *(last - 1);
+					g_histograms.pop_back();
+				}
+				else
+				{
+					++it;
+					++i;
 				}
 			}
+			ImGui::Columns(1);
 		}
 
-#define PAD_AND_SET_IMGUI_CURSOR(cursor, pad) cursor.x += pad; ImGui::SetCursorPos(cursor)
-
-		void renderCallee(Edge *callee, bool callerTooltip)
+		void renderHeaps()
 		{
-			if (!callee)
-				return;
-
-			ImGui::PushID(callee);
-			const char *suffix;
-			if (g_updateType != UpdateType::NONE)
-			{
-				callee->allocSizeCache = callee->allocSize;
-			}
-			float size = formatMemoryString(callee->allocSizeCache, suffix);
-			auto cursorPos = ImGui::GetCursorPos();
-			const bool opened = ImGui::TreeNode(callee, "%4.0f %s", size, suffix);
-#ifdef LMT_INSTANCE_COUNT_ACTIVATED
-			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-			ImGui::Text("%4u", callee->instanceCount);
-#endif
-#ifdef LMT_CAPTURE_ACTIVATED
-			ptrdiff_t diff = callee->allocSizeCache - callee->allocSizeCapture;
-			size = formatMemoryString(diff, suffix);
-			const char *capturedSuffix;
-			float capturedSize = formatMemoryString(callee->allocSizeCapture, capturedSuffix);
+			ImGui::Separator();
+			ImVec2 cursorPos = ImGui::GetCursorPos();
+			ImGui::Text("Size");
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-			if (diff > 0)
-			{
-				ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "%4.0f %s", size, suffix);
-			}
-			else
+			ImGui::Text("Heap");
+			ImGui::Separator();
+			for (size_t i = 0; i < LMT_HEAP_NUMBER; ++i)
 			{
-				ImGui::TextColored(ImVec4(0.f, 1.f, 0.f, 1.f), "%4.0f %s", size, suffix);
+				if (g_heapNames[i] == nullptr && g_heapAllocSize[i] == 0)
+					continue;
+				cursorPos = ImGui::GetCursorPos();
+				const char *suffix;
+				float size = formatMemoryString(g_heapAllocSize[i], suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				if (g_heapNames[i])
+					ImGui::Text("%s", g_heapNames[i]);
+				else
+					ImGui::Text("Heap %i", int(i));
 			}
+		}
+
+		void renderTags()
+		{
+			ImGui::Separator();
+			ImVec2 cursorPos = ImGui::GetCursorPos();
+			ImGui::Text("Size");
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-			ImGui::Text("[%4.0f %s]", capturedSize, capturedSuffix);
-#endif
+			ImGui::Text("Budget");
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-			ImGui::Text("%s", callee->alloc->str);
-			if (callerTooltip && ImGui::IsItemHovered())
+			ImGui::Text("Tag");
+			ImGui::Separator();
+			const uint16_t count = g_tagCounter.load();
+			for (uint16_t i = 0; i < count; ++i)
 			{
-				ImGui::BeginTooltip();
-				size_t depth;
-				displayCallerTooltip(callee->from, depth);
-				ImGui::EndTooltip();
+				ImVec2 screenPos = ImGui::GetCursorScreenPos();
+				cursorPos = ImGui::GetCursorPos();
+				const char *suffix;
+				float size = formatMemoryString(g_tagAllocSize[i], suffix);
+				if (g_tagOverBudget[i])
+					ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "%4.0f %s", size, suffix);
+				else
+					ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				if (g_tagBudgets[i] != 0)
+				{
+					float budget = formatMemoryString(ptrdiff_t(g_tagBudgets[i]), suffix);
+					ImGui::Text("%4.0f %s", budget, suffix);
+				}
+				else
+				{
+					ImGui::TextDisabled("-");
+				}
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				ImGui::Text("%s", g_tagNames[i]);
+				if (g_tagBudgets[i] != 0)
+				{
+					float ratio = float(g_tagAllocSize[i]) / g_tagBudgets[i];
+					ratio = ratio > 1.f ? 1.f : (ratio < 0.f ? 0.f : ratio);
+					ImGui::GetWindowDrawList()->AddRectFilled(screenPos, ImVec2(screenPos.x + ratio * ImGui::GetWindowContentRegionWidth(), ImGui::GetCursorScreenPos().y), g_tagOverBudget[i] ? 0x3F0000FF : 0x3F025CAB);
+				}
 			}
-			if (ImGui::BeginPopupContextItem("Options"))
+		}
+
+		// Fragmentation : 1 - largest free block / free memory
+		void computePoolFragmentation()
+		{
+			g_poolBlocks.clear();
+			for (auto &e : g_poolTable)
 			{
-				if (ImGui::Selectable("Watch call"))
+				if (e.ptr != nullptr && !e.freed && g_pools[e.pool].capacity != 0)
 				{
-					createHistogram(callee);
+					PoolBlock block;
+					block.begin = size_t(e.ptr);
+					block.end = size_t(e.ptr) + e.size;
+					block.pool = e.pool;
+					g_poolBlocks.push_back(block);
 				}
-				if (ImGui::Selectable("Watch function"))
+			}
+			std::sort(g_poolBlocks.begin(), g_poolBlocks.end(), [](const PoolBlock &a, const PoolBlock &b){ return a.pool != b.pool ? a.pool < b.pool : a.begin < b.begin; });
+			const PoolBlock *block = g_poolBlocks.begin();
+			for (uint8_t i = 0; i < LMT_POOL_NUMBER + LMT_RESOURCE_KIND_NUMBER; ++i)
+			{
+				const Pool &p = g_pools[i];
+				g_poolFragmentation[i] = 0.f;
+				if (p.capacity == 0)
+					continue;
+				size_t cursor = size_t(p.base);
+				size_t largest = 0;
+				size_t free = 0;
+				for (; block != g_poolBlocks.end() && block->pool == i; ++block)
 				{
-					createHistogram(callee->alloc);
-					g_displayType = DisplayType::HISTOGRAMS;
+					if (block->begin > cursor)
+					{
+						free += block->begin - cursor;
+						largest = block->begin - cursor > largest ? block->begin - cursor : largest;
+					}
+					cursor = block->end > cursor ? block->end : cursor;
 				}
-				if (ImGui::Selectable("Function view"))
+				const size_t poolEnd = size_t(p.base) + p.capacity;
+				if (poolEnd > cursor)
 				{
-					g_functionView = callee->alloc;
-					g_displayType = DisplayType::FUNCTION;
-					g_updateType = UpdateType::CURRENT_AND_NEXT_FRAME;
+					free += poolEnd - cursor;
+					largest = poolEnd - cursor > largest ? poolEnd - cursor : largest;
 				}
-				ImGui::EndPopup();
+				g_poolFragmentation[i] = free ? 1.f - float(largest) / free : 0.f;
 			}
-			if (opened)
+			g_poolFragmentationComputed = true;
+		}
+
+		void renderPools()
+		{
+			if (ImGui::Button("Compute fragmentation"))
 			{
-				if (g_updateType != UpdateType::NONE || g_refeshAuto == false)
+				computePoolFragmentation();
+			}
+			for (uint8_t i = 0; i < LMT_POOL_NUMBER + LMT_RESOURCE_KIND_NUMBER; ++i)
+			{
+				Pool &p = g_pools[i];
+				if (p.name == nullptr && p.root == nullptr)
+					continue;
+				ImGui::PushID(i);
+				ImGui::Separator();
+				const char *suffix;
+				float size = formatMemoryString(p.allocSize, suffix);
+				const char *peakSuffix;
+				float peak = formatMemoryString(p.peakSize, peakSuffix);
+				ImGui::Text("%s", p.root ? p.root->str : p.rootName);
+				ImGui::Text("Live : %4.0f %s | Peak : %4.0f %s | Count : %i", size, suffix, peak, peakSuffix, int(p.count));
+				if (p.capacity != 0)
 				{
-					std::stable_sort(callee->to.begin(), callee->to.end(), [](Edge *a, Edge *b){ return a->allocSizeCache > b->allocSizeCache; });
+					ImGui::SameLine();
+					ImGui::Text("| Occupancy : %0.2f%%", float(p.allocSize) / p.capacity * 100.f);
+					if (g_poolFragmentationComputed)
+					{
+						ImGui::SameLine();
+						ImGui::Text("| Fragmentation : %0.2f%%", g_poolFragmentation[i] * 100.f);
+					}
 				}
-				for (auto &to : callee->to)
+				if (p.root && p.root->edges != EDGE_NONE)
 				{
-					renderCallee(to, callerTooltip);
+					renderCallee(p.root->edges, false);
 				}
-				ImGui::TreePop();
+				ImGui::PopID();
 			}
-			ImGui::PopID();
 		}
 
-		void renderCallees()
+#ifdef LMT_CHURN_ACTIVATED
+		void updateChurnRates()
+		{
+			if (g_churnElapsed <= 0.f)
+				return;
+			for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
+			{
+				stack->allocRate = (stack->churn.allocCount - stack->churnCache.allocCount) / g_churnElapsed;
+				stack->bytesRate = (stack->churn.allocBytes - stack->churnCache.allocBytes) / g_churnElapsed;
+				stack->freeRate = (stack->churn.freeCount - stack->churnCache.freeCount) / g_churnElapsed;
+				stack->churnCache = stack->churn;
+			}
+			g_churnElapsed = 0.f;
+		}
+
+		void renderChurn()
 		{
 			ImGui::Separator();
 			ImVec2 cursorPos = ImGui::GetCursorPos();
-			ImGui::Text("Size");
-#ifdef LMT_INSTANCE_COUNT_ACTIVATED
+			ImGui::Text("Bytes/s");
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-			ImGui::Text("Count");
-#endif
-#ifdef LMT_CAPTURE_ACTIVATED
+			ImGui::Text("Allocs/s");
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-			ImGui::Text("Diff");
+			ImGui::Text("Frees/s");
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-			ImGui::Text("Captured");
-#endif
+			ImGui::Text("Allocs");
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-			ImGui::Text("Callee");
+			ImGui::Text("Stack");
 			ImGui::Separator();
-			ImGui::BeginChild("Content", ImGui::GetWindowContentRegionMax(), false, ImGuiWindowFlags_HorizontalScrollbar);
-			Alloc *callee = g_searchResult;
-			int i = 0;
-			while (callee)
+
+			if (g_updateType != UpdateType::NONE || g_churnStacks.begin() == g_churnStacks.end())
 			{
-				if (!callee->edges)
+				g_churnStacks.clear();
+				for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
 				{
-					callee = callee->next;
-					continue;
+					if (stack->churn.allocCount != 0 && stack->stackSize > 0)
+						g_churnStacks.push_back(stack);
 				}
+				std::stable_sort(g_churnStacks.begin(), g_churnStacks.end(), [](const AllocStack *a, const AllocStack *b){ return a->bytesRate > b->bytesRate; });
+			}
 
-				ImGui::PushID(callee);
-				++i;
-				auto cursorPos = ImGui::GetCursorPos();
-				if (i % 2)
-				{
-					ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.4f, 0.4f, 0.78f, 0.45f));
-					ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.4f, 0.4f, 0.78f, 0.65f));
-					ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.4f, 0.4f, 0.78f, 0.85f));
-				}
-				else
-				{
-					ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.4f, 0.57f, 0.78f, 0.45f));
-					ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.4f, 0.57f, 0.78f, 0.65f));
-					ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.4f, 0.57f, 0.78f, 0.85f));
-				}
-				bool opened = ImGui::CollapsingHeader("##dummy", "NoName", true, false);
-				if (ImGui::BeginPopupContextItem("Options"))
+			ImGui::BeginChild("Content", ImGui::GetWindowContentRegionMax(), false, ImGuiWindowFlags_HorizontalScrollbar);
+			for (auto &stack : g_churnStacks)
+			{
+				ImGui::PushID(stack);
+				cursorPos = ImGui::GetCursorPos();
+				const char *suffix;
+				float size = formatMemoryString(ptrdiff_t(stack->bytesRate), suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				ImGui::Text("%8.0f", stack->allocRate);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				ImGui::Text("%8.0f", stack->freeRate);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				ImGui::Text("%8llu", (unsigned long long)stack->churn.allocCount);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				Alloc **stackAllocs = getStackAllocs(*stack);
+				ImGui::Text("%s", stackAllocs[0]->str);
+				if (ImGui::IsItemHovered())
 				{
-					if (ImGui::Selectable("Watch function"))
-					{
-						createHistogram(callee);
-						g_displayType = DisplayType::HISTOGRAMS;
-					}
-					if (ImGui::Selectable("Function view"))
+					ImGui::BeginTooltip();
+					for (uint8_t i = 0; i < stack->stackSize; ++i)
 					{
-						g_functionView = callee;
-						g_displayType = DisplayType::FUNCTION;
-						g_updateType = UpdateType::CURRENT_AND_NEXT_FRAME;
+						ImGui::Text("%s", stackAllocs[i]->str);
 					}
-					ImGui::EndPopup();
+					ImGui::EndTooltip();
 				}
+				ImGui::PopID();
+			}
+			ImGui::EndChild();
+		}
+#endif
 
-				cursorPos.x += 20;
-				cursorPos.y += 3;
-				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 0);
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+		void renderLive()
+		{
+			ImGui::Text("Live heap allocations : %i", int(g_liveTable.size() - g_liveFreedCount));
+			if (g_liveTable.dropped() != 0)
+			{
+				ImGui::SameLine();
+				ImGui::TextColored(ImColor(1.f, 0.f, 0.f), "Dropped : %i (LMT_LIVE_TABLE_SIZE)", int(g_liveTable.dropped()));
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Dump heap"))
+			{
+				writeHeapDump(LMT_HEAP_DUMP_PATH);
+			}
+			ImGui::InputText("Address", g_liveAddressStr, sizeof(g_liveAddressStr));
+			ImGui::Separator();
+
+			const size_t address = size_t(strtoull(g_liveAddressStr, nullptr, 16));
+			if (address == 0)
+			{
+				ImGui::TextDisabled("Type an hexadecimal address to find the allocation containing it");
+				return;
+			}
+			// Interior pointers are accepted, so all the table is searched
+			for (auto &e : g_liveTable)
+			{
+				if (e.ptr == nullptr || e.freed || address < size_t(e.ptr) || address >= size_t(e.ptr) + (e.size ? e.size : 1))
+					continue;
 				const char *suffix;
-				float size = formatMemoryString(callee->allocSizeCache, suffix);
-				ImGui::Text("%4.0f %s", size, suffix);
-				float nextPad = 80.f;
-#ifdef LMT_INSTANCE_COUNT_ACTIVATED
-				PAD_AND_SET_IMGUI_CURSOR(cursorPos, nextPad);
-				nextPad = 100.f;
-#endif
-#ifdef LMT_CAPTURE_ACTIVATED
-				ptrdiff_t diff = callee->allocSizeCache - callee->allocSizeCapture;
-				size = formatMemoryString(diff, suffix);
-				const char *capturedSuffix;
-				float capturedSize = formatMemoryString(callee->allocSizeCapture, capturedSuffix);
-				PAD_AND_SET_IMGUI_CURSOR(cursorPos, nextPad);
-				if (diff > 0)
+				float size = formatMemoryString(ptrdiff_t(e.size), suffix);
+				ImGui::Text("%p | %4.0f %s | Heap : %s | Time : %llu", e.ptr, size, suffix, g_heapNames[e.pool] ? g_heapNames[e.pool] : "Unknown", (unsigned long long)e.time);
+				ImGui::Separator();
+				const AllocStack &stack = g_stackDictionary.update(e.stack)->getValue();
+				if (stack.stackSize == 0)
 				{
-					ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "%4.0f %s", size, suffix);
+					ImGui::Text("%s", UNKNOWN_STACK_NAME);
+					return;
 				}
-				else
+				Alloc **stackAllocs = getStackAllocs(stack);
+				for (uint8_t i = 0; i < stack.stackSize; ++i)
 				{
-					ImGui::TextColored(ImVec4(0.f, 1.f, 0.f, 1.f), "%4.0f %s", size, suffix);
+					ImGui::Text("%s", stackAllocs[i]->str);
 				}
-				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-				ImGui::Text("[%4.0f %s]", capturedSize, capturedSuffix);
+				return;
+			}
+			ImGui::TextDisabled("No live allocation at this address");
+		}
 #endif
+
+#ifdef LMT_GENERATION_ACTIVATED
+		void renderSinceMark()
+		{
+			const int current = int(g_generation.load(std::memory_order_relaxed));
+			const int oldest = current >= LMT_GENERATION_NUMBER ? current - LMT_GENERATION_NUMBER + 1 : 0;
+			if (g_sinceMarkGeneration < oldest || g_sinceMarkGeneration > current)
+				g_sinceMarkGeneration = current;
+			bool changed = ImGui::SliderInt("Since mark", &g_sinceMarkGeneration, oldest, current);
+
+			ImGui::Separator();
+			ImVec2 cursorPos = ImGui::GetCursorPos();
+			ImGui::Text("Since mark");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Live");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Stack");
+			ImGui::Separator();
+
+			const uint32_t generation = uint32_t(g_sinceMarkGeneration);
+			if (changed || g_updateType != UpdateType::NONE || g_sinceMarkStacks.begin() == g_sinceMarkStacks.end())
+			{
+				g_sinceMarkStacks.clear();
+				for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
+				{
+					if (stack->stackSize > 0 && getSizeSinceMark(*stack, generation) > 0)
+						g_sinceMarkStacks.push_back(stack);
+				}
+				std::stable_sort(g_sinceMarkStacks.begin(), g_sinceMarkStacks.end(), [=](const AllocStack *a, const AllocStack *b){ return getSizeSinceMark(*a, generation) > getSizeSinceMark(*b, generation); });
+			}
+
+			ImGui::BeginChild("Content", ImGui::GetWindowContentRegionMax(), false, ImGuiWindowFlags_HorizontalScrollbar);
+			for (auto &stack : g_sinceMarkStacks)
+			{
+				ImGui::PushID(stack);
+				cursorPos = ImGui::GetCursorPos();
+				const char *suffix;
+				float size = formatMemoryString(getSizeSinceMark(*stack, generation), suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
 				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
-				ImGui::Text("%s", callee->str);
-				if (opened)
+				size = formatMemoryString(stack->allocSize, suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				Alloc **stackAllocs = getStackAllocs(*stack);
+				ImGui::Text("%s", stackAllocs[0]->str);
+				if (ImGui::IsItemHovered())
 				{
-					g_sortedEdges.clear();
-					Edge *edge = callee->edges;
-					while (edge)
-					{
-						auto it = std::lower_bound(g_sortedEdges.begin(), g_sortedEdges.end(), edge, [](const Edge *a, const Edge *b){ return a->allocSizeCache > b->allocSizeCache; });
-						if (it == g_sortedEdges.end() || *it != edge)
-						{
-							g_sortedEdges.insert(it, edge);
-						}
-						edge = edge->same;
-					}
-					for (auto &e : g_sortedEdges)
+					ImGui::BeginTooltip();
+					for (uint8_t i = 0; i < stack->stackSize; ++i)
 					{
-						renderCallee(e, true);
+						ImGui::Text("%s", stackAllocs[i]->str);
 					}
+					ImGui::EndTooltip();
 				}
 				ImGui::PopID();
-				ImGui::PopStyleColor(3);
-				callee = callee->next;
 			}
 			ImGui::EndChild();
 		}
+#endif
 
-		void renderFunctionView()
+#ifdef LMT_USE_USABLE_SIZE
+		void renderWaste()
 		{
-			if (!g_functionView)
-				return;
-			ImGui::Columns(3);
+			const char *suffix;
+			float size = formatMemoryString(g_slackSize, suffix);
+			ImGui::Text("Rounded up by the allocator : %4.0f %s", size, suffix);
 
-			//////////////////////////////////////////////////////////////////////////
-			// CALLERS
-			Edge *edge = g_functionView->edges;
-			size_t total = 0;
-			g_groupedEdges.clear();
+			ImGui::Separator();
+			ImVec2 cursorPos = ImGui::GetCursorPos();
+			ImGui::Text("Waste");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Asked");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Ratio");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Stack");
+			ImGui::Separator();
 
-			while (edge)
+			if (g_updateType != UpdateType::NONE || g_wasteStacks.begin() == g_wasteStacks.end())
 			{
-				if (edge->from)
+				g_wasteStacks.clear();
+				for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
 				{
-					GroupedEdge group;
-					if (g_updateType != UpdateType::NONE)
-					{
-						edge->allocSizeCache = edge->allocSize;
-					}
-					group.alloc = edge->from->alloc;
-					group.allocSize = 0;
+					if (stack->slackSize > 0 && stack->stackSize > 0)
+						g_wasteStacks.push_back(stack);
+				}
+				std::stable_sort(g_wasteStacks.begin(), g_wasteStacks.end(), [](const AllocStack *a, const AllocStack *b){ return a->slackSize > b->slackSize; });
+			}
 
-					auto it = std::lower_bound(g_groupedEdges.begin(), g_groupedEdges.end(), group, InsertSortedEdge);
-					if (it == g_groupedEdges.end() || it->alloc != group.alloc)
+			ImGui::BeginChild("Content", ImGui::GetWindowContentRegionMax(), false, ImGuiWindowFlags_HorizontalScrollbar);
+			for (auto &stack : g_wasteStacks)
+			{
+				ImGui::PushID(stack);
+				cursorPos = ImGui::GetCursorPos();
+				size = formatMemoryString(stack->slackSize, suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				size = formatMemoryString(stack->allocSize, suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				ImGui::Text("%5.1f %%", stack->allocSize > 0 ? 100.f * stack->slackSize / (stack->allocSize + stack->slackSize) : 100.f);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				Alloc **stackAllocs = getStackAllocs(*stack);
+				ImGui::Text("%s", stackAllocs[0]->str);
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::BeginTooltip();
+					for (uint8_t i = 0; i < stack->stackSize; ++i)
 					{
-						it = g_groupedEdges.insert(it, group);
+						ImGui::Text("%s", stackAllocs[i]->str);
 					}
-					total += edge->allocSizeCache;
-					it->allocSize += edge->allocSizeCache;
+					ImGui::EndTooltip();
 				}
-				edge = edge->same;
+				ImGui::PopID();
 			}
+			ImGui::EndChild();
+		}
+#endif
 
-			std::stable_sort(g_groupedEdges.begin(), g_groupedEdges.end(), SortGroupedEdge);
+#ifdef LMT_FRAME_ACTIVATED
+		void renderFrames()
+		{
+			int budget = int(g_frameBudget / 1024);
+			if (ImGui::InputInt("Budget (KiB)", &budget))
+			{
+				g_frameBudget = budget > 0 ? size_t(budget) * 1024 : 0;
+			}
 
-			for (auto &caller : g_groupedEdges)
+			// Frames are listed from the oldest one, the last one is still running
+			// and events of the recent ones can be in chunks not treated yet
+			const uint32_t current = g_frameIndex.load(std::memory_order_relaxed);
+			const uint32_t first = current >= LMT_FRAME_HISTORY ? current - LMT_FRAME_HISTORY + 1 : 0;
+			uint64_t maxBytes = g_frameBudget;
+			for (uint32_t i = first; i <= current; ++i)
 			{
-				ImVec2 cursorPos = ImGui::GetCursorScreenPos();
+				const Frame &frame = g_frames[i % LMT_FRAME_HISTORY];
+				if (frame.index == i && frame.allocBytes > maxBytes)
+					maxBytes = frame.allocBytes;
+			}
+
+			const float height = 80.f;
+			const float barWidth = ImGui::GetWindowContentRegionWidth() / LMT_FRAME_HISTORY;
+			ImVec2 origin = ImGui::GetCursorScreenPos();
+			ImDrawList *drawList = ImGui::GetWindowDrawList();
+			const bool clicked = ImGui::InvisibleButton("##FrameTimeline", ImVec2(ImGui::GetWindowContentRegionWidth(), height));
+			const bool hovered = ImGui::IsItemHovered();
+			const uint32_t mouseFrame = first + uint32_t((ImGui::GetIO().MousePos.x - origin.x) / barWidth);
+			for (uint32_t i = first; i <= current; ++i)
+			{
+				const Frame &frame = g_frames[i % LMT_FRAME_HISTORY];
+				if (frame.index != i || maxBytes == 0)
+					continue;
+				const float x = origin.x + (i - first) * barWidth;
+				const float barHeight = height * float(frame.allocBytes) / maxBytes;
+				ImU32 color = g_frameBudget != 0 && frame.allocBytes > g_frameBudget ? 0xFF0000FF : 0xFF025CAB;
+				if (i == g_frameSelected)
+					color = 0xFFFFFFFF;
+				drawList->AddRectFilled(ImVec2(x, origin.y + height - barHeight), ImVec2(x + barWidth - 1.f, origin.y + height), color);
+			}
+			if (g_frameBudget != 0)
+			{
+				const float y = origin.y + height - height * float(g_frameBudget) / maxBytes;
+				drawList->AddLine(ImVec2(origin.x, y), ImVec2(origin.x + ImGui::GetWindowContentRegionWidth(), y), 0xFF0000FF);
+			}
+			if (hovered && mouseFrame <= current && g_frames[mouseFrame % LMT_FRAME_HISTORY].index == mouseFrame)
+			{
+				const Frame &frame = g_frames[mouseFrame % LMT_FRAME_HISTORY];
 				const char *suffix;
-				float size = formatMemoryString(caller.allocSize, suffix);
-				ImGui::TextWrapped("%s\n%4.0f%s", caller.alloc->str, size, suffix);
-				ImVec2 cursorPosNext = ImGui::GetCursorScreenPos();
-				ImGui::SetCursorScreenPos(cursorPos);
-				ImGui::PushID(caller.alloc);
-				if (ImGui::InvisibleButton("##Finvisible", ImVec2(ImGui::GetColumnWidth(), cursorPosNext.y - cursorPos.y)))
-				{
-					g_functionView = caller.alloc;
-					g_updateType = UpdateType::CURRENT_AND_NEXT_FRAME;
-				}
-				if (ImGui::BeginPopupContextItem("Options"))
+				float size = formatMemoryString(ptrdiff_t(frame.allocBytes), suffix);
+				ImGui::SetTooltip("Frame %u\nAllocated : %4.0f %s\nAllocs : %u | Frees : %u", mouseFrame, size, suffix, frame.allocCount, frame.freeCount);
+				if (clicked)
+					g_frameSelected = mouseFrame;
+			}
+
+			ImGui::Separator();
+			if (g_frameSelected == uint32_t(-1) || g_frames[g_frameSelected % LMT_FRAME_HISTORY].index != g_frameSelected)
+			{
+				ImGui::TextDisabled("Click on a frame to see its biggest stacks");
+				return;
+			}
+			const Frame &frame = g_frames[g_frameSelected % LMT_FRAME_HISTORY];
+			const char *suffix;
+			float size = formatMemoryString(ptrdiff_t(frame.allocBytes), suffix);
+			ImGui::Text("Frame %u | Allocated : %4.0f %s | Allocs : %u | Frees : %u", g_frameSelected, size, suffix, frame.allocCount, frame.freeCount);
+			ImGui::Separator();
+			for (size_t i = 0; i < LMT_FRAME_TOP_STACKS; ++i)
+			{
+				const FrameStack &entry = frame.stacks[i];
+				if (entry.stack == nullptr || entry.stack->stackSize == 0)
+					continue;
+				ImGui::PushID(int(i));
+				ImVec2 cursorPos = ImGui::GetCursorPos();
+				size = formatMemoryString(ptrdiff_t(entry.allocBytes), suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				Alloc **stackAllocs = getStackAllocs(*entry.stack);
+				ImGui::Text("%s", stackAllocs[0]->str);
+				if (ImGui::IsItemHovered())
 				{
-					if (ImGui::Selectable("Watch function"))
+					ImGui::BeginTooltip();
+					for (uint8_t j = 0; j < entry.stack->stackSize; ++j)
 					{
-						createHistogram(caller.alloc);
-						g_displayType = DisplayType::HISTOGRAMS;
+						ImGui::Text("%s", stackAllocs[j]->str);
 					}
-					ImGui::EndPopup();
+					ImGui::EndTooltip();
 				}
 				ImGui::PopID();
-				ImGui::GetWindowDrawList()->AddRectFilled(cursorPos, ImVec2(cursorPos.x + float(caller.allocSize) / total * ImGui::GetColumnWidth(), ImGui::GetCursorScreenPos().y), 0x3F025CAB);
 			}
+		}
+#endif
 
-			//////////////////////////////////////////////////////////////////////////
-			// FUNCTION
-			ImGui::NextColumn();
-
+#ifdef LMT_PEAK_ACTIVATED
+		void renderPeak()
+		{
 			const char *suffix;
-			if (g_updateType != UpdateType::NONE)
+			float size = formatMemoryString(g_liveSize, suffix);
+			const char *peakSuffix;
+			float peak = formatMemoryString(g_peakSize, peakSuffix);
+			const char *snapshotSuffix;
+			float snapshot = formatMemoryString(g_peakSnapshot.allocSize, snapshotSuffix);
+			ImGui::Text("Live : %4.0f %s | Peak : %4.0f %s | Snapshot : %4.0f %s", size, suffix, peak, peakSuffix, snapshot, snapshotSuffix);
+			ImGui::SameLine();
+			if (ImGui::Button("Reset"))
 			{
-				g_functionView->allocSizeCache = g_functionView->allocSize;
-			}
-			float size = formatMemoryString(g_functionView->allocSizeCache, suffix);
-			ImGui::TextWrapped("%s\n%4.0f%s", g_functionView->str, size, suffix);
-			ImGui::PushID(g_functionView);
-			if (ImGui::BeginPopupContextItem("Options"))
-			{
-				if (ImGui::Selectable("Watch function"))
-				{
-					createHistogram(g_functionView);
-					g_displayType = DisplayType::HISTOGRAMS;
-				}
-				ImGui::EndPopup();
+				resetPeak();
 			}
-			ImGui::PopID();
-
-			//////////////////////////////////////////////////////////////////////////
-			// CALLEE
-			ImGui::NextColumn();
 
-			edge = g_functionView->edges;
-			g_groupedEdges.clear();
-			total = 0;
+			ImGui::Separator();
+			ImVec2 cursorPos = ImGui::GetCursorPos();
+			ImGui::Text("At peak");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Live");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Stack peak");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Stack");
+			ImGui::Separator();
 
-			while (edge)
+			ImGui::BeginChild("Content", ImGui::GetWindowContentRegionMax(), false, ImGuiWindowFlags_HorizontalScrollbar);
+			for (size_t i = 0; i < g_peakSnapshot.count; ++i)
 			{
-				for (auto &to : edge->to)
+				const PeakEntry &entry = g_peakSnapshot.entries[i];
+				ImGui::PushID(entry.stack);
+				ImVec2 screenPos = ImGui::GetCursorScreenPos();
+				cursorPos = ImGui::GetCursorPos();
+				size = formatMemoryString(entry.allocSize, suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				size = formatMemoryString(entry.stack->allocSize, suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				size = formatMemoryString(entry.stack->peakSize, suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				Alloc **stackAllocs = getStackAllocs(*entry.stack);
+				ImGui::Text("%s", entry.stack->stackSize > 0 ? stackAllocs[0]->str : UNKNOWN_STACK_NAME);
+				if (ImGui::IsItemHovered())
 				{
-					GroupedEdge group;
-					if (g_updateType != UpdateType::NONE)
-					{
-						to->allocSizeCache = to->allocSize;
-					}
-					group.alloc = to->alloc;
-					group.allocSize = 0;
-
-					auto it = std::lower_bound(g_groupedEdges.begin(), g_groupedEdges.end(), group, InsertSortedEdge);
-					if (it == g_groupedEdges.end() || it->alloc != group.alloc)
+					ImGui::BeginTooltip();
+					for (uint8_t j = 0; j < entry.stack->stackSize; ++j)
 					{
-						it = g_groupedEdges.insert(it, group);
+						ImGui::Text("%s", stackAllocs[j]->str);
 					}
-
-					it->allocSize += to->allocSizeCache;
-					total += to->allocSizeCache;
+					ImGui::EndTooltip();
 				}
-				edge = edge->same;
+				const float ratio = float(entry.allocSize) / g_peakSnapshot.allocSize;
+				ImGui::GetWindowDrawList()->AddRectFilled(screenPos, ImVec2(screenPos.x + ratio * ImGui::GetWindowContentRegionWidth(), ImGui::GetCursorScreenPos().y), 0x3F025CAB);
+				ImGui::PopID();
 			}
+			ImGui::EndChild();
+		}
+#endif
 
-			std::stable_sort(g_groupedEdges.begin(), g_groupedEdges.end(), SortGroupedEdge);
-
-			for (auto &callee : g_groupedEdges)
+#ifdef LMT_LIFETIME_ACTIVATED
+		// LMT_TIMESTAMP frequency is measured against steady_clock since the first call
+		void updateTicksPerSecond()
+		{
+			const uint64_t ticks = LMT_TIMESTAMP();
+			const auto time = std::chrono::steady_clock::now();
+			if (g_lifetimeStartTicks == 0)
 			{
-				ImVec2 cursorPos = ImGui::GetCursorScreenPos();
-				const char *suffix;
-				float size = formatMemoryString(callee.allocSize, suffix);
-				ImGui::TextWrapped("%s\n%4.0f%s", callee.alloc->str, size, suffix);
-				ImVec2 cursorPosNext = ImGui::GetCursorScreenPos();
-				ImGui::SetCursorScreenPos(cursorPos);
-				ImGui::PushID(callee.alloc);
-				if (ImGui::InvisibleButton("##invisible", ImVec2(ImGui::GetColumnWidth(), cursorPosNext.y - cursorPos.y)))
-				{
-					g_functionView = callee.alloc;
-					g_updateType = UpdateType::CURRENT_AND_NEXT_FRAME;
-				}
-				if (ImGui::BeginPopupContextItem("Options"))
-				{
-					if (ImGui::Selectable("Watch function"))
-					{
-						createHistogram(callee.alloc);
-						g_displayType = DisplayType::HISTOGRAMS;
-					}
-					ImGui::EndPopup();
-				}
-				ImGui::PopID();
-				ImGui::GetWindowDrawList()->AddRectFilled(cursorPos, ImVec2(cursorPos.x + float(callee.allocSize) / total * ImGui::GetColumnWidth(), ImGui::GetCursorScreenPos().y), 0x3F025CAB);
+				g_lifetimeStartTicks = ticks;
+				g_lifetimeStartTime = time;
+				return;
 			}
+			const double seconds = std::chrono::duration<double>(time - g_lifetimeStartTime).count();
+			if (seconds > 0.0)
+				g_ticksPerSecond = double(ticks - g_lifetimeStartTicks) / seconds;
+		}
 
-			ImGui::Columns(1);
+		void formatTicks(uint64_t ticks, char *str, size_t length)
+		{
+			if (g_ticksPerSecond <= 0.0)
+			{
+				LMT_SNPRINTF(str, length, "%llu ticks", (unsigned long long)ticks);
+				return;
+			}
+			const double seconds = double(ticks) / g_ticksPerSecond;
+			if (seconds < 1e-3)
+				LMT_SNPRINTF(str, length, "%.1f us", seconds * 1e6);
+			else if (seconds < 1.0)
+				LMT_SNPRINTF(str, length, "%.1f ms", seconds * 1e3);
+			else
+				LMT_SNPRINTF(str, length, "%.1f s", seconds);
 		}
 
-		void renderHistograms()
+		void renderLifetimes()
 		{
-			const int columnNumber = 3;
-			int i = 0;
-			float histoW = ImGui::GetWindowContentRegionWidth() / columnNumber;
-			ImVec2 graphSize(histoW, histoW * 0.4f);
-			auto it = g_histograms.begin();
-			while (it != g_histograms.end())
+			char maxLifetime[32];
+			formatTicks(uint64_t(1) << (g_lifetimeMaxBucket + LIFETIME_TICK_SHIFT + 1), maxLifetime, sizeof(maxLifetime));
+			bool changed = ImGui::SliderInt("Max lifetime", &g_lifetimeMaxBucket, 0, LIFETIME_BUCKET_NUMBER - 1, maxLifetime);
+
+			ImGui::Separator();
+			ImVec2 cursorPos = ImGui::GetCursorPos();
+			ImGui::Text("Bytes");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Frees");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Average");
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Stack");
+			ImGui::Separator();
+
+			// Short lived bytes are the average size multiplied by the number of frees
+			auto shortLivedBytes = [](const AllocStack *stack)
 			{
-				auto &h = *it;
+				uint64_t bytes = 0;
+				for (int i = 0; i <= g_lifetimeMaxBucket; ++i)
+					bytes += stack->lifetimeBytes[i];
+				return bytes;
+			};
+			auto shortLivedCount = [](const AllocStack *stack)
+			{
+				uint64_t count = 0;
+				for (int i = 0; i <= g_lifetimeMaxBucket; ++i)
+					count += stack->lifetimes[i];
+				return count;
+			};
 
-				bool toDelete = false;
-				ImGui::PushID(i);
-				ImGui::PushItemWidth(histoW);
-				ImGui::BeginGroup();
-				ImGui::BeginGroup();
-				ImGui::TextColored(h.isFunction ? ImColor(217, 164, 22) : ImColor(209, 6, 145), "%s", h.isFunction ? "Function" : "Call"); ImGui::SameLine();
-				const char *suffix;
-				float size = formatMemoryString(h.allocSizeCache, suffix);
-				ImGui::Text("%4.0f %s", size, suffix);
-				if (h.isFunction == false)
-				{
-					ImGui::SameLine();
-					ImGui::TextDisabled("(?)");
-					if (ImGui::IsItemHovered())
-					{
-						ImGui::BeginTooltip();
-						size_t depth;
-						displayCallerTooltip(h.call->from, depth);
-						ImGui::EndTooltip();
-					}
-				}
-				ImGui::Text("%.*s", int(histoW * 0.145f), h.name);
-				if (ImGui::IsItemHovered())
+			if (changed || g_updateType != UpdateType::NONE || g_lifetimeStacks.begin() == g_lifetimeStacks.end())
+			{
+				g_lifetimeStacks.clear();
+				for (AllocStack *stack = g_allocStackList; stack != nullptr; stack = stack->next)
 				{
-					ImGui::SetTooltip(h.name);
+					if (stack->stackSize > 0 && shortLivedCount(stack) != 0)
+						g_lifetimeStacks.push_back(stack);
 				}
-				ImVec2 cursorPos = ImGui::GetCursorPos();
-				ImGui::PlotLines("##NoName", (const float*)h.allocSize, HISTORY_FRAME_NUMBER, h.cursor, nullptr, 0, FLT_MAX, graphSize, sizeof(ptrdiff_t));
-				ImGui::SetCursorPos(cursorPos);
-				ImGui::InvisibleButton("##invisibleButton", graphSize);
+				std::stable_sort(g_lifetimeStacks.begin(), g_lifetimeStacks.end(), [&](const AllocStack *a, const AllocStack *b){ return shortLivedBytes(a) > shortLivedBytes(b); });
+			}
+
+			ImGui::BeginChild("Content", ImGui::GetWindowContentRegionMax(), false, ImGuiWindowFlags_HorizontalScrollbar);
+			for (auto &stack : g_lifetimeStacks)
+			{
+				ImGui::PushID(stack);
+				const uint64_t bytes = shortLivedBytes(stack);
+				const uint64_t count = shortLivedCount(stack);
+				cursorPos = ImGui::GetCursorPos();
+				const char *suffix;
+				float size = formatMemoryString(ptrdiff_t(bytes), suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				ImGui::Text("%8llu", (unsigned long long)count);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				size = formatMemoryString(ptrdiff_t(bytes / count), suffix);
+				ImGui::Text("%4.0f %s", size, suffix);
+				PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+				Alloc **stackAllocs = getStackAllocs(*stack);
+				ImGui::Text("%s", stackAllocs[0]->str);
 				if (ImGui::IsItemHovered())
 				{
-					ImVec2 itemMin = ImGui::GetItemRectMin();
-					ImGuiIO& g = ImGui::GetIO();
-					const float x = (graphSize.x - (g.MousePos.x - itemMin.x)) / graphSize.x;
-					const int itemCount = HISTORY_FRAME_NUMBER;
-					const int id = itemCount - (int)(x * itemCount);
-					const int itemIndex = (id + h.cursor) % itemCount;
-
-					ImGui::SetTooltip("");
 					ImGui::BeginTooltip();
-					const char *ttSuffix;
-					float ttSize = formatMemoryString(h.allocSize[itemIndex], ttSuffix);
-					ImGui::Text("%4.0f %s", ttSize, ttSuffix);
+					float values[LIFETIME_BUCKET_NUMBER];
+					for (uint8_t i = 0; i < LIFETIME_BUCKET_NUMBER; ++i)
+						values[i] = float(stack->lifetimes[i]);
+					ImGui::PlotHistogram("##Lifetimes", values, LIFETIME_BUCKET_NUMBER, 0, "Lifetimes", 0.f, FLT_MAX, ImVec2(300.f, 40.f));
+					for (uint8_t i = 0; i < stack->stackSize; ++i)
+					{
+						ImGui::Text("%s", stackAllocs[i]->str);
+					}
 					ImGui::EndTooltip();
 				}
-				ImGui::EndGroup();
-				if (ImGui::BeginPopupContextItem("Options"))
-				{
-					toDelete = ImGui::Selectable("Delete");
-					ImGui::EndPopup();
-				}
-				ImGui::EndGroup();
-				ImGui::PopItemWidth();
 				ImGui::PopID();
-				if ((i % columnNumber) < columnNumber - 1)
-					ImGui::SameLine();
-				else
-					ImGui::Separator();
-				if (toDelete)
-				{
-					Histogram *last = g_histograms.end();
-					*it = *(last - 1);
-					g_histograms.pop_back();
-				}
-				else
+			}
+			ImGui::EndChild();
+		}
+#endif
+
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+		void renderSizeClasses(const uint32_t *sizeClasses)
+		{
+			float values[SIZE_CLASS_NUMBER];
+			uint8_t last = 0;
+			for (uint8_t i = 0; i < SIZE_CLASS_NUMBER; ++i)
+			{
+				values[i] = float(sizeClasses[i]);
+				if (sizeClasses[i] != 0)
+					last = i;
+			}
+			// Empty classes after the biggest one are not displayed
+			ImGui::PlotHistogram("##SizeClasses", values, last + 1, 0, nullptr, 0.f, FLT_MAX, ImVec2(ImGui::GetColumnWidth() - 16.f, 40.f));
+			if (ImGui::IsItemHovered())
+			{
+				ImGui::BeginTooltip();
+				for (uint8_t i = 0; i <= last; ++i)
 				{
-					++it;
-					++i;
+					if (sizeClasses[i] == 0)
+						continue;
+					const char *suffix;
+					float size = formatMemoryString(ptrdiff_t(1) << i, suffix);
+					ImGui::Text(">= %4.0f%s : %u", size, suffix, sizeClasses[i]);
 				}
+				ImGui::EndTooltip();
 			}
-			ImGui::Columns(1);
 		}
+#endif
 
 		void createHistogram(Alloc *function)
 		{
@@ -1775,7 +4789,7 @@ namespace LiveMemTracer
 			g_histograms.push_back(histogram);
 		}
 
-		void createHistogram(Edge *functionCall)
+		void createHistogram(EdgeIndex functionCall)
 		{
 			for (auto &h : g_histograms)
 			{
@@ -1784,7 +4798,7 @@ namespace LiveMemTracer
 			}
 			Histogram histogram;
 			histogram.call = functionCall;
-			histogram.name = functionCall->alloc->str;
+			histogram.name = g_edges[functionCall].alloc->str;
 			histogram.isFunction = false;
 			g_histograms.push_back(histogram);
 		}
@@ -1798,6 +4812,10 @@ namespace LiveMemTracer
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
 			ImGui::Text("Count");
 #endif
+#ifdef LMT_CHURN_ACTIVATED
+			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
+			ImGui::Text("Allocs");
+#endif
 #ifdef LMT_CAPTURE_ACTIVATED
 			PAD_AND_SET_IMGUI_CURSOR(cursorPos, 100);
 			ImGui::Text("Diff");
@@ -1808,49 +4826,39 @@ namespace LiveMemTracer
 			ImGui::Text("Callee");
 			ImGui::Separator();
 			ImGui::BeginChild("Content", ImGui::GetWindowContentRegionMax(), false, ImGuiWindowFlags_HorizontalScrollbar);
-			for (auto &root : g_allocStackRoots)
+			if (g_updateType != UpdateType::NONE || g_refeshAuto == false)
 			{
-				renderCallee(root, false);
+				g_firstRoot = sortSiblings(g_firstRoot);
 			}
-			ImGui::EndChild();
-		}
-
-		void recursiveCacheData(Edge *edge)
-		{
-			edge->alloc->allocSizeCache = edge->alloc->allocSize;
-			for (auto &n : edge->to)
+			for (EdgeIndex root = g_firstRoot; root != EDGE_NONE; root = g_edges[root].nextSibling)
 			{
-				n->allocSizeCache = n->allocSize;
-				recursiveCacheData(n);
+				renderCallee(root, false);
 			}
+			ImGui::EndChild();
 		}
 
 		void cacheData()
 		{
-			for (auto &r : g_allocStackRoots)
+			const EdgeIndex count = g_edgeCount;
+			for (EdgeIndex i = 1; i < count; ++i)
 			{
-				r->allocSizeCache = r->allocSize;
-				recursiveCacheData(r);
+				Edge &edge = g_edges[i];
+				edge.allocSizeCache = g_edgeSizes[i];
+				if (edge.alloc)
+					edge.alloc->allocSizeCache = edge.alloc->allocSize;
 			}
 		}
 
 #ifdef LMT_CAPTURE_ACTIVATED
-		void recursiveCapture(Edge *edge)
-		{
-			edge->alloc->allocSizeCapture = edge->alloc->allocSize;
-			edge->allocSizeCapture = edge->allocSize;
-			for (auto &n : edge->to)
-			{
-				n->allocSizeCapture = n->allocSize;
-				recursiveCapture(n);
-			}
-		}
-
 		void capture()
 		{
-			for (auto &r : g_allocStackRoots)
+			const EdgeIndex count = g_edgeCount;
+			for (EdgeIndex i = 1; i < count; ++i)
 			{
-				recursiveCapture(r);
+				Edge &edge = g_edges[i];
+				edge.allocSizeCapture = g_edgeSizes[i];
+				if (edge.alloc)
+					edge.alloc->allocSizeCapture = edge.alloc->allocSize;
 			}
 		}
 #endif
@@ -1882,6 +4890,13 @@ namespace LiveMemTracer
 				{
 					capture();
 				}
+#endif
+#ifdef LMT_SIZE_CLASS_ACTIVATED
+				ImGui::SameLine();
+				if (ImGui::Button("Export sizes"))
+				{
+					exportSizeClasses(LMT_SIZE_CLASS_EXPORT_PATH);
+				}
 #endif
 				ImGui::SameLine();
 				if (ImGui::InputText("Search", g_searchStr, g_search_str_length))
@@ -1900,18 +4915,27 @@ namespace LiveMemTracer
 				if (ImGui::IsItemHovered())
 				{
 					ImGui::BeginTooltip();
+					// Tables counters are plain values written by treatChunk
+					std::lock_guard<std::mutex> lock(g_mutex);
 					ImGui::Text("LMT's static allocations : %0.2f Mo\n", float(g_internalAllThreadsMemoryUsed.load()) / 1024.f / 1024.f);
 					ImGui::Text("LMT's dynamic allocations : %0.2f Mo", float(g_internalAllocations.load()) / 1024.f / 1024.f);
 					ImGui::Separator();
 #ifdef LMT_STATS
-					ImGui::Text("Total allocation asked : %0.2f Mo | Real allocation done : %0.2f Mo", float(g_userAllocations.load()) / 1024.f / 1024.f, float(g_realUserAllocations.load()) / 1024.f / 1024.f);
+					ImGui::Text("Total allocation asked : %0.2f Mo | Real allocation done : %0.2f Mo", float(sumStatsSlots(&StatsSlot::userAllocations)) / 1024.f / 1024.f, float(sumStatsSlots(&StatsSlot::realUserAllocations)) / 1024.f / 1024.f);
 					ImGui::Separator();
-					ImGui::Text("Stack dictionary : %0.2f iterations per search | filled : %0.2f%% (LMT_STACK_DICTIONARY_SIZE) | %0.2f Mo", g_stackDictionary.getHitStats(), g_stackDictionary.getRatio(), sizeof(g_stackDictionary) / 1024.f / 1024.f);
-					ImGui::Text("Alloc dictionary : %0.2f iterations per search | filled : %0.2f%% (LMT_ALLOC_DICTIONARY_SIZE) | %0.2f Mo", g_allocDictionary.getHitStats(), g_allocDictionary.getRatio(), sizeof(g_allocDictionary) / 1024.f / 1024.f);
-					ImGui::Text("Tree dictionary  : %0.2f iterations per search | filled : %0.2f%% (LMT_TREE_DICTIONARY_SIZE)  | %0.2f Mo", g_treeDictionary.getHitStats(), g_treeDictionary.getRatio(), sizeof(g_treeDictionary) / 1024.f / 1024.f);
+					ImGui::Text("Stack dictionary : %0.2f iterations per search | filled : %0.2f%% (LMT_STACK_DICTIONARY_SIZE) | %0.2f Mo", g_stackDictionary.getHitStats(), g_stackDictionary.getRatio(), g_stackDictionary.RESERVED_SIZE / 1024.f / 1024.f);
+					ImGui::Text("Alloc dictionary : %0.2f iterations per search | filled : %0.2f%% (LMT_ALLOC_DICTIONARY_SIZE) | %0.2f Mo", g_allocDictionary.getHitStats(), g_allocDictionary.getRatio(), g_allocDictionary.RESERVED_SIZE / 1024.f / 1024.f);
+					ImGui::Text("Tree dictionary  : %0.2f iterations per search | filled : %0.2f%% (LMT_TREE_DICTIONARY_SIZE)  | %0.2f Mo", g_treeDictionary.getHitStats(), g_treeDictionary.getRatio(), g_treeDictionary.RESERVED_SIZE / 1024.f / 1024.f);
+					if (g_truncatedTreeStacks != 0)
+						ImGui::TextColored(ImColor(1.f, 0.f, 0.f), "Tree is full, %i stack events truncated (LMT_TREE_DICTIONARY_SIZE)", int(g_truncatedTreeStacks));
+					ImGui::Text("Pool table : filled : %0.2f%% (LMT_POOL_TABLE_SIZE) | dropped : %i | %0.2f Mo", g_poolTable.getRatio(), int(g_poolTable.dropped()), g_poolTable.RESERVED_SIZE / 1024.f / 1024.f);
 					ImGui::Separator();
 #endif
-					ImGui::TextWrapped("Note that dictionaries are allocated at init and are not resizable. If you enable LMT_DEBUG_DEV a full dictionary will trigger an assert, if not execution will continue but statistics can be corrupted.\nThe more the dictionary is full, the more the number of iterations increase when searching into dictionary, a 90%% full dictionary is a bad idea.");
+#ifdef LMT_STACK_VERIFY
+					ImGui::Text("Stack hash collisions : %i", int(g_stackCollisions));
+					ImGui::Separator();
+#endif
+					ImGui::TextWrapped("Note that dictionaries are reserved at init and are not resizable, their memory is only used when touched. If you enable LMT_DEBUG_DEV a full dictionary will trigger an assert, if not execution will continue but statistics can be corrupted.\nThe more the dictionary is full, the more the number of iterations increase when searching into dictionary, a 90%% full dictionary is a bad idea.");
 					ImGui::EndTooltip();
 				}
 				ImGui::PopItemWidth();
@@ -1923,6 +4947,9 @@ namespace LiveMemTracer
 		{
 			g_updateSearch = false;
 			g_updateRatio += dt;
+#ifdef LMT_CHURN_ACTIVATED
+			g_churnElapsed += dt;
+#endif
 			bool second = false;
 			if (ImGui::Begin("LiveMemoryProfiler", nullptr, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_MenuBar))
 			{
@@ -1939,6 +4966,7 @@ namespace LiveMemTracer
 				}
 				ImGui::Separator();
 
+				// Views look into the dictionaries, they have to keep the lock
 				std::lock_guard<std::mutex> lock(g_mutex);
 				if (g_updateSearch)
 				{
@@ -1964,12 +4992,72 @@ namespace LiveMemTracer
 				{
 					renderFunctionView();
 				}
+				else if (g_displayType == DisplayType::HEAPS)
+				{
+					renderHeaps();
+				}
+				else if (g_displayType == DisplayType::TAGS)
+				{
+					renderTags();
+				}
+				else if (g_displayType == DisplayType::POOLS)
+				{
+					renderPools();
+				}
+#ifdef LMT_CHURN_ACTIVATED
+				else if (g_displayType == DisplayType::CHURN)
+				{
+					renderChurn();
+				}
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+				else if (g_displayType == DisplayType::LIFETIMES)
+				{
+					renderLifetimes();
+				}
+#endif
+#ifdef LMT_PEAK_ACTIVATED
+				else if (g_displayType == DisplayType::PEAK)
+				{
+					renderPeak();
+				}
+#endif
+#ifdef LMT_FRAME_ACTIVATED
+				else if (g_displayType == DisplayType::FRAMES)
+				{
+					renderFrames();
+				}
+#endif
+#ifdef LMT_USE_USABLE_SIZE
+				else if (g_displayType == DisplayType::WASTE)
+				{
+					renderWaste();
+				}
+#endif
+#ifdef LMT_GENERATION_ACTIVATED
+				else if (g_displayType == DisplayType::SINCE_MARK)
+				{
+					renderSinceMark();
+				}
+#endif
+#ifdef LMT_LIVE_TABLE_ACTIVATED
+				else if (g_displayType == DisplayType::LIVE)
+				{
+					renderLive();
+				}
+#endif
 			}
 			ImGui::End();
 
 			if (second)
 			{
 				std::lock_guard<std::mutex> lock(g_mutex);
+#ifdef LMT_CHURN_ACTIVATED
+				updateChurnRates();
+#endif
+#ifdef LMT_LIFETIME_ACTIVATED
+				updateTicksPerSecond();
+#endif
 				for (auto &h : g_histograms)
 				{
 					if (h.isFunction)
@@ -1979,7 +5067,7 @@ namespace LiveMemTracer
 					}
 					else
 					{
-						h.allocSizeCache = h.call->allocSize;
+						h.allocSizeCache = g_edgeSizes[h.call];
 						h.allocSize[h.cursor] = h.allocSizeCache;
 					}
 					h.cursor = (h.cursor + 1) % HISTORY_FRAME_NUMBER;
@@ -18,19 +18,31 @@ namespace LiveMemTracer
 {
 	typedef void* StackInfo;
 
+	// CaptureStackBackTrace hash is free but only 32 bits, the depth and the
+	// innermost frame extend it to 64 bits without walking the frames again.
+	// LMT_STACK_VERIFY compares the full frames.
+	static inline Hash extendBackTraceHash(DWORD backTraceHash, void *frame, uint32_t count)
+	{
+		return combineHash(frame, combineHash(count, Hash(backTraceHash)));
+	}
+
 	static inline uint32_t getCallstack(uint32_t maxStackSize, void **stack, Hash *hash)
 	{
-		uint32_t count = CaptureStackBackTrace(INTERNAL_FRAME_TO_SKIP, maxStackSize, stack, (PDWORD)hash);
+		DWORD backTraceHash = 0;
+		uint32_t count = CaptureStackBackTrace(INTERNAL_FRAME_TO_SKIP, maxStackSize, stack, &backTraceHash);
 
 		if (count == maxStackSize)
 		{
 			void* tmpStack[INTERNAL_MAX_STACK_DEPTH];
-			uint32_t tmpSize = CaptureStackBackTrace(INTERNAL_FRAME_TO_SKIP, INTERNAL_MAX_STACK_DEPTH, tmpStack, (PDWORD)hash);
+			uint32_t tmpSize = CaptureStackBackTrace(INTERNAL_FRAME_TO_SKIP, INTERNAL_MAX_STACK_DEPTH, tmpStack, &backTraceHash);
 
 			for (uint32_t i = 0; i < maxStackSize - 1; i++)
 				stack[maxStackSize - 1 - i] = tmpStack[tmpSize - 1 - i];
 			stack[0] = (void*)~0;
+			*hash = extendBackTraceHash(backTraceHash, tmpStack[0], tmpSize);
+			return count;
 		}
+		*hash = extendBackTraceHash(backTraceHash, count > 0 ? stack[0] : nullptr, count);
 		return count;
 	}
 
@@ -0,0 +1,201 @@
+// Benchmarks of LiveMemTracer, without display.
+// Each case prints the median of 7 runs, after a first run creating the stacks and nodes.
+// Features are the ones defined in the project (LMT_LIVE_TABLE_ACTIVATED,
+// LMT_INSTANCE_COUNT_ACTIVATED...), LMT_ENABLED=0 only runs the alloc / free loop, for reference.
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h> //QueryPerformanceCounter, steady_clock of Visual Studio 2013 is too coarse
+#endif
+
+#ifndef LMT_ENABLED
+#define LMT_ENABLED 1
+#endif
+#define LMT_IMGUI 0
+#define LMT_USE_MALLOC ::malloc
+#define LMT_USE_REALLOC ::realloc
+#define LMT_USE_FREE ::free
+// Room for the 10 000 callees and their stacks
+#define LMT_ALLOC_DICTIONARY_SIZE 1024 * 64
+#define LMT_STACK_DICTIONARY_SIZE 1024 * 64
+#define LMT_TREE_DICTIONARY_SIZE 1024 * 64
+
+#if defined(_WIN64) || defined(__x86_64__)
+#define LMT_x64
+#else
+#define LMT_x86
+#endif
+
+#define LMT_IMPL 1
+
+#include "../src/LiveMemTracer.hpp"
+
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+static const int RUN_NUMBER = 7;
+
+static double nowNs()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return double(counter.QuadPart) * (1e9 / double(frequency.QuadPart));
+#else
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Run returns the cost of one unit in ns
+template <typename Run>
+static void report(const char *name, const char *unit, Run run)
+{
+	run();
+	double results[RUN_NUMBER];
+	for (int i = 0; i < RUN_NUMBER; ++i)
+		results[i] = run();
+	std::sort(results, results + RUN_NUMBER);
+	printf("%-56s %10.1f ns per %s\n", name, results[RUN_NUMBER / 2], unit);
+}
+
+// Storing results after the calls keeps the frames (no tail call)
+static void *volatile g_sink = nullptr;
+
+//////////////////////////////////////////////////////////////////////////
+// Alloc / free loop, the cost of an event with the features of this build
+
+static double runAllocFreeLoop()
+{
+	static const size_t LIVE = 100000;
+	static const size_t COUNT = 2000000;
+	static void *live[LIVE];
+
+	const double begin = nowNs();
+	for (size_t i = 0; i < COUNT; ++i)
+	{
+		void *&ptr = live[(i * 7919) % LIVE];
+		if (ptr)
+			LMT_DEALLOC(ptr);
+		ptr = LMT_ALLOC(i % 256 + 1);
+	}
+	LMT_FLUSH();
+	const double end = nowNs();
+
+	for (size_t i = 0; i < LIVE; ++i)
+	{
+		LMT_DEALLOC(live[i]);
+		live[i] = nullptr;
+	}
+	LMT_FLUSH();
+	return (end - begin) / double(2 * COUNT - LIVE);
+}
+
+#if LMT_ENABLED
+
+//////////////////////////////////////////////////////////////////////////
+// 10 000 distinct callees of the same function
+
+#define BENCH_CALLEE(n)\
+	BENCH_NOINLINE void *benchCallee##n(size_t size) { void *ptr = LMT_ALLOC(size); g_sink = ptr; return ptr; }
+#define BENCH_CALLEE_ADDRESS(n) &benchCallee##n,
+#define BENCH_10(m, n) m(n##0) m(n##1) m(n##2) m(n##3) m(n##4) m(n##5) m(n##6) m(n##7) m(n##8) m(n##9)
+#define BENCH_100(m, n) BENCH_10(m, n##0) BENCH_10(m, n##1) BENCH_10(m, n##2) BENCH_10(m, n##3) BENCH_10(m, n##4)\
+	BENCH_10(m, n##5) BENCH_10(m, n##6) BENCH_10(m, n##7) BENCH_10(m, n##8) BENCH_10(m, n##9)
+#define BENCH_1000(m, n) BENCH_100(m, n##0) BENCH_100(m, n##1) BENCH_100(m, n##2) BENCH_100(m, n##3) BENCH_100(m, n##4)\
+	BENCH_100(m, n##5) BENCH_100(m, n##6) BENCH_100(m, n##7) BENCH_100(m, n##8) BENCH_100(m, n##9)
+#define BENCH_10000(m) BENCH_1000(m, 0) BENCH_1000(m, 1) BENCH_1000(m, 2) BENCH_1000(m, 3) BENCH_1000(m, 4)\
+	BENCH_1000(m, 5) BENCH_1000(m, 6) BENCH_1000(m, 7) BENCH_1000(m, 8) BENCH_1000(m, 9)
+
+BENCH_10000(BENCH_CALLEE)
+
+typedef void *(*Callee)(size_t size);
+static const Callee g_callees[] = { BENCH_10000(BENCH_CALLEE_ADDRESS) };
+static const size_t CALLEE_NUMBER = sizeof(g_callees) / sizeof(g_callees[0]);
+
+BENCH_NOINLINE void *benchHub(size_t index, size_t size)
+{
+	void *ptr = g_callees[index](size);
+	g_sink = ptr;
+	return ptr;
+}
+
+// Adds depth frames above the hub
+BENCH_NOINLINE void *benchDepth(int depth, size_t index, size_t size)
+{
+	void *ptr = depth == 0 ? benchHub(index, size) : benchDepth(depth - 1, index, size);
+	g_sink = ptr;
+	return ptr;
+}
+
+// Events are logged untimed, only their treatment (updateStack / updateTree) is timed.
+// Batches are small enough for a chunk, so chunks are only treated by LMT_FLUSH.
+static const size_t BATCH_SIZE = 1000;
+static void *g_batch[BATCH_SIZE];
+
+static double treatBatches(size_t calleeNumber, int depth)
+{
+	double treatment = 0.0;
+	for (size_t first = 0; first < calleeNumber; first += BATCH_SIZE)
+	{
+		for (size_t i = 0; i < BATCH_SIZE; ++i)
+			g_batch[i] = benchDepth(depth, first + i, 16);
+		double begin = nowNs();
+		LMT_FLUSH();
+		treatment += nowNs() - begin;
+
+		for (size_t i = 0; i < BATCH_SIZE; ++i)
+			LMT_DEALLOC(g_batch[i]);
+		begin = nowNs();
+		LMT_FLUSH();
+		treatment += nowNs() - begin;
+	}
+	return treatment / double(2 * calleeNumber);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Hash of a frame address, for the dictionaries and the live tables
+
+static double runCombineHash()
+{
+	static const size_t COUNT = 1 << 24;
+	const uint64_t module = 0x00007FF6A1230000ULL;
+	LiveMemTracer::Hash sum = 0;
+	const double begin = nowNs();
+	for (size_t i = 0; i < COUNT; ++i)
+		sum ^= LiveMemTracer::combineHash(module + i * 16);
+	const double end = nowNs();
+	g_sink = (void*)size_t(sum);
+	return (end - begin) / double(COUNT);
+}
+
+static double runFanOut() { return treatBatches(CALLEE_NUMBER, 0); }
+static double runDeepTree() { return treatBatches(BATCH_SIZE, 16); }
+
+#endif
+
+int main()
+{
+	LMT_INIT();
+
+#if LMT_ENABLED
+	report("combineHash of a frame address", "hash", runCombineHash);
+	report("Treatment, 10 000 callees of one function", "event", runFanOut);
+	report("Treatment, 1 000 stacks of 16 more frames", "event", runDeepTree);
+#endif
+	report("Alloc / free loop, 100 000 live allocations", "event", runAllocFreeLoop);
+
+	LMT_EXIT();
+	return 0;
+}
@@ -372,6 +372,7 @@ int main(int ac, char **av)
 
 		for (int i = 0; i < 100; ++i)
 		{
+			LMT_SCOPE_TAG("Toto");
 			auto lambda = [&](){
 				totoVector.push_back(new Toto());
 			};
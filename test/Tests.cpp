@@ -0,0 +1,755 @@
+// Accounting tests of LiveMemTracer, without display.
+// Chunks are treated on the calling thread, each test flushes before reading the tables.
+// Returns the number of failed checks.
+
+// Reports written by LMT are read back with fopen
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+#define LMT_ENABLED 1
+#define LMT_IMGUI 0
+#define LMT_USE_MALLOC ::malloc
+#define LMT_USE_REALLOC ::realloc
+#define LMT_USE_FREE ::free
+#define LMT_DEBUG_DEV 1
+#define LMT_STATS 1
+#define LMT_COLLAPSE_RECURSION 1
+#define LMT_LIFETIME_ACTIVATED 1
+#define LMT_PEAK_ACTIVATED 1
+#define LMT_GENERATION_ACTIVATED 1
+#define LMT_LIVE_TABLE_ACTIVATED 1
+
+#if defined(_WIN64) || defined(__x86_64__)
+#define LMT_x64
+#else
+#define LMT_x86
+#endif
+
+#define LMT_IMPL 1
+
+// Functions whose frames are checked keep their own frame, they are extern "C"
+// so that both symbol getters return their plain name. Storing the result after
+// the call prevents tail calls.
+#if defined(_MSC_VER)
+#define TEST_NOINLINE __declspec(noinline)
+#else
+#define TEST_NOINLINE __attribute__((noinline))
+#endif
+
+#include "../src/LiveMemTracer.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(condition)\
+	do {\
+		if (!(condition)) {\
+			fprintf(stderr, "%s(%d) : check failed : %s\n", __FILE__, __LINE__, #condition);\
+			++g_failures;\
+		}\
+	} while (0)
+
+// Treats the chunk of this thread and reads a table value under LMT's lock
+template <typename T>
+static T flushAndRead(const T &value)
+{
+	LMT_FLUSH();
+	std::lock_guard<std::mutex> lock(LiveMemTracer::g_mutex);
+	return value;
+}
+
+static ptrdiff_t heapSize(uint8_t heap)
+{
+	return flushAndRead(LiveMemTracer::g_heapAllocSize[heap]);
+}
+
+static LiveMemTracer::Alloc *findAlloc(const char *name)
+{
+	LMT_FLUSH();
+	std::lock_guard<std::mutex> lock(LiveMemTracer::g_mutex);
+	for (LiveMemTracer::Alloc *alloc = LiveMemTracer::g_allocList; alloc != nullptr; alloc = alloc->next)
+	{
+		if (alloc->str != nullptr && strcmp(alloc->str, name) == 0)
+			return alloc;
+	}
+	return nullptr;
+}
+
+static bool isAligned(void *ptr, size_t alignment)
+{
+	return ptr != nullptr && (uintptr_t(ptr) & (alignment - 1)) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Allocation API
+
+static void testAllocationApi()
+{
+	const ptrdiff_t before = heapSize(LiveMemTracer::DefaultHeap::ID);
+
+	int *zeroed = (int*)LMT_CALLOC(16, sizeof(int));
+	CHECK(zeroed != nullptr);
+	if (zeroed)
+	{
+		int sum = 0;
+		for (int i = 0; i < 16; ++i)
+			sum |= zeroed[i];
+		CHECK(sum == 0);
+		CHECK(LMT_USABLE_SIZE(zeroed) == 16 * sizeof(int));
+	}
+	CHECK(LMT_USABLE_SIZE(nullptr) == 0);
+
+	// count * size and the header don't fit in a size_t
+	CHECK(LMT_CALLOC(size_t(-1) / 2, 4) == nullptr);
+	CHECK(LMT_CALLOC(size_t(-1), size_t(-1)) == nullptr);
+	CHECK(LMT_CALLOC(1, size_t(-1)) == nullptr);
+
+	errno = 0;
+	CHECK(LMT_ALIGNED_ALLOC(3, 64) == nullptr);
+	CHECK(errno == EINVAL);
+	errno = 0;
+	CHECK(LMT_ALIGNED_ALLOC(0, 64) == nullptr);
+	CHECK(errno == EINVAL);
+	void *aligned = LMT_ALIGNED_ALLOC(256, 512);
+	CHECK(isAligned(aligned, 256));
+
+	void *memaligned = nullptr;
+	CHECK(LMT_POSIX_MEMALIGN(&memaligned, 3, 64) == EINVAL);
+	// Power of two, but not a multiple of sizeof(void*)
+	CHECK(LMT_POSIX_MEMALIGN(&memaligned, sizeof(void*) / 2, 64) == EINVAL);
+	CHECK(memaligned == nullptr);
+	CHECK(LMT_POSIX_MEMALIGN(&memaligned, 128, 100) == 0);
+	CHECK(isAligned(memaligned, 128));
+
+	void *grown = LMT_REALLOC(nullptr, 10);
+	grown = LMT_REALLOC(grown, 100);
+	CHECK(LMT_USABLE_SIZE(grown) == 100);
+
+	CHECK(heapSize(LiveMemTracer::DefaultHeap::ID) - before == ptrdiff_t(16 * sizeof(int) + 512 + 100 + 100));
+
+	LMT_DEALLOC(zeroed);
+	LMT_DEALLOC_ALIGNED(aligned);
+	LMT_DEALLOC_ALIGNED(memaligned);
+	LMT_DEALLOC(grown);
+	CHECK(heapSize(LiveMemTracer::DefaultHeap::ID) == before);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Heap policies
+
+static int g_countingHeapBlocks = 0;
+
+struct CountingHeap
+{
+	static const uint8_t ID = 1;
+	static const char *name() { return "Counting"; }
+	static void *allocate(size_t size) { ++g_countingHeapBlocks; return ::malloc(size); }
+	static void *reallocate(void *ptr, size_t size) { return ::realloc(ptr, size); }
+	static void deallocate(void *ptr) { --g_countingHeapBlocks; ::free(ptr); }
+};
+
+static void testHeapPolicies()
+{
+	LMT_REGISTER_HEAP(CountingHeap);
+	CHECK(strcmp(LiveMemTracer::g_heapNames[CountingHeap::ID], "Counting") == 0);
+
+	const ptrdiff_t defaultBefore = heapSize(LiveMemTracer::DefaultHeap::ID);
+	const ptrdiff_t before = heapSize(CountingHeap::ID);
+
+	void *block = LMT_ALLOC_HEAP(CountingHeap, 1000);
+	block = LMT_REALLOC_HEAP(CountingHeap, block, 3000);
+	void *aligned = LMT_ALLOC_ALIGNED_HEAP(CountingHeap, 100, 64);
+	CHECK(isAligned(aligned, 64));
+	// Aligned reallocations move the block, through the same heap
+	aligned = LMT_REALLOC_ALIGNED_HEAP(CountingHeap, aligned, 200, 64);
+	CHECK(isAligned(aligned, 64));
+	CHECK(g_countingHeapBlocks == 2);
+
+	CHECK(heapSize(CountingHeap::ID) - before == 3000 + 200);
+	CHECK(heapSize(LiveMemTracer::DefaultHeap::ID) == defaultBefore);
+
+	LMT_DEALLOC_HEAP(CountingHeap, block);
+	LMT_DEALLOC_ALIGNED_HEAP(CountingHeap, aligned);
+	CHECK(g_countingHeapBlocks == 0);
+	CHECK(heapSize(CountingHeap::ID) == before);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tags
+
+static int g_budgetCalls = 0;
+static size_t g_budgetLastSize = 0;
+
+static void onTagBudget(const char *tag, size_t budget, size_t allocSize)
+{
+	CHECK(strcmp(tag, "TestPhysics") == 0);
+	CHECK(budget == 5000);
+	++g_budgetCalls;
+	g_budgetLastSize = allocSize;
+	// Called outside of LMT's lock, allocating and flushing from here is fine
+	LMT_DEALLOC(LMT_ALLOC(16));
+	LMT_FLUSH();
+}
+
+static void testTags()
+{
+	LMT_SET_TAG_BUDGET_CALLBACK(onTagBudget);
+	LMT_SET_TAG_BUDGET("TestPhysics", 5000);
+	const uint8_t physics = LiveMemTracer::registerTag("TestPhysics");
+	const uint8_t network = LiveMemTracer::registerTag("TestNetwork");
+	CHECK(physics != 0 && network != 0 && physics != network);
+
+	void *blocks[10];
+	{
+		LMT_SCOPE_TAG("TestPhysics");
+		for (int i = 0; i < 10; ++i)
+			blocks[i] = LMT_ALLOC(1000);
+		{
+			LMT_SCOPE_TAG("TestNetwork");
+			LMT_DEALLOC(LMT_ALLOC(10));
+		}
+	}
+	CHECK(flushAndRead(LiveMemTracer::g_tagAllocSize[physics]) == 10000);
+	CHECK(flushAndRead(LiveMemTracer::g_tagAllocSize[network]) == 0);
+	CHECK(g_budgetCalls == 1);
+	// Size when the budget was crossed, events of a call site may be merged in the chunk
+	CHECK(g_budgetLastSize > 5000 && g_budgetLastSize <= 10000);
+
+	// Frees are credited to the tag of the allocation, whatever the current scope
+	for (int i = 0; i < 4; ++i)
+		LMT_DEALLOC(blocks[i]);
+	CHECK(flushAndRead(LiveMemTracer::g_tagAllocSize[physics]) == 6000);
+	CHECK(g_budgetCalls == 1);
+
+	// Called again once the tag went back under its budget
+	for (int i = 4; i < 10; ++i)
+		LMT_DEALLOC(blocks[i]);
+	CHECK(flushAndRead(LiveMemTracer::g_tagAllocSize[physics]) == 0);
+	{
+		LMT_SCOPE_TAG("TestPhysics");
+		blocks[0] = LMT_ALLOC(6000);
+	}
+	CHECK(flushAndRead(LiveMemTracer::g_tagAllocSize[physics]) == 6000);
+	CHECK(g_budgetCalls == 2);
+	LMT_DEALLOC(blocks[0]);
+	LMT_SET_TAG_BUDGET_CALLBACK(nullptr);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Pools
+
+static void testPools()
+{
+	static char memory[64 * 64];
+	const uint8_t id = 2;
+	LMT_REGISTER_POOL(id, "TestParticles", memory, sizeof(memory));
+	const LiveMemTracer::Pool &pool = LiveMemTracer::g_pools[id];
+	const ptrdiff_t heapBefore = heapSize(LiveMemTracer::DefaultHeap::ID);
+
+	for (int i = 0; i < 64; ++i)
+		LMT_POOL_ALLOC(id, memory + i * 64, 64);
+	for (int i = 0; i < 64; i += 2)
+		LMT_POOL_FREE(id, memory + i * 64);
+	CHECK(flushAndRead(pool.allocSize) == 32 * 64);
+	CHECK(flushAndRead(pool.count) == 32);
+	CHECK(flushAndRead(pool.peakSize) == 64 * 64);
+	CHECK(pool.root != nullptr && strcmp(pool.root->str, "[Pool] TestParticles") == 0);
+	CHECK(pool.root != nullptr && flushAndRead(pool.root->allocSize) == 32 * 64);
+	// Pools are not part of the heaps
+	CHECK(heapSize(LiveMemTracer::DefaultHeap::ID) == heapBefore);
+
+	for (int i = 1; i < 64; i += 2)
+		LMT_POOL_FREE(id, memory + i * 64);
+	CHECK(flushAndRead(pool.allocSize) == 0);
+	CHECK(flushAndRead(pool.count) == 0);
+
+	// Pointer reused by another thread, whose chunk is treated first
+	LMT_POOL_ALLOC(id, memory, 16);
+	LMT_POOL_FREE(id, memory);
+	std::thread([&]{ LMT_POOL_ALLOC(id, memory, 48); LMT_FLUSH(); }).join();
+	CHECK(flushAndRead(pool.allocSize) == 48);
+	CHECK(flushAndRead(pool.count) == 1);
+
+	// Free treated before the allocation it releases
+	std::thread([&]{ LMT_POOL_FREE(id, memory); LMT_POOL_ALLOC(id, memory + 64, 8); LMT_FLUSH(); }).join();
+	CHECK(flushAndRead(pool.allocSize) == 8);
+	CHECK(flushAndRead(pool.count) == 1);
+
+	LMT_POOL_FREE(id, memory + 64);
+	CHECK(flushAndRead(pool.allocSize) == 0);
+	CHECK(flushAndRead(pool.count) == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Resources
+
+static void testResources()
+{
+	LMT_REGISTER_RESOURCE_KIND(1, "TestFiles");
+	LMT_REGISTER_RESOURCE_KIND(2, "TestBuffers");
+	const LiveMemTracer::Pool &files = LiveMemTracer::g_pools[LMT_POOL_NUMBER + 1];
+	const LiveMemTracer::Pool &buffers = LiveMemTracer::g_pools[LMT_POOL_NUMBER + 2];
+	const ptrdiff_t heapBefore = heapSize(LiveMemTracer::DefaultHeap::ID);
+
+	// Handle 0 is valid, and handles of different kinds don't collide
+	LMT_TRACK_RESOURCE(1, 0, 1 << 20);
+	LMT_TRACK_RESOURCE(1, 3, 1 << 10);
+	LMT_TRACK_RESOURCE(2, 3, 512);
+	CHECK(flushAndRead(files.allocSize) == (1 << 20) + (1 << 10));
+	CHECK(flushAndRead(files.count) == 2);
+	CHECK(flushAndRead(buffers.allocSize) == 512);
+	CHECK(files.root != nullptr && strcmp(files.root->str, "[Resource] TestFiles") == 0);
+	CHECK(files.root != nullptr && flushAndRead(files.root->allocSize) == (1 << 20) + (1 << 10));
+	CHECK(heapSize(LiveMemTracer::DefaultHeap::ID) == heapBefore);
+
+	LMT_UNTRACK_RESOURCE(1, 0);
+	CHECK(flushAndRead(files.allocSize) == 1 << 10);
+	CHECK(flushAndRead(files.count) == 1);
+	CHECK(flushAndRead(buffers.allocSize) == 512);
+
+	LMT_UNTRACK_RESOURCE(1, 3);
+	LMT_UNTRACK_RESOURCE(2, 3);
+	CHECK(flushAndRead(files.allocSize) == 0);
+	CHECK(flushAndRead(buffers.allocSize) == 0);
+	CHECK(flushAndRead(buffers.count) == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Hash distribution
+
+static int countBits(uint64_t value)
+{
+	int count = 0;
+	for (; value != 0; value &= value - 1)
+		++count;
+	return count;
+}
+
+// Dictionaries index keys with hash % capacity, low bits have to be as good as high ones
+template <typename Dictionary>
+static void checkDistribution(const LiveMemTracer::Hash *hashes, size_t count, Dictionary &dictionary)
+{
+	for (size_t i = 0; i < count; ++i)
+		dictionary.update(hashes[i]);
+	// Linear probing at 50% load, about 0.5 extra probe per insertion with a uniform hash
+	CHECK(dictionary.getHitStats() < 1.f);
+
+	size_t buckets[64] = {};
+	for (size_t i = 0; i < count; ++i)
+		++buckets[hashes[i] % 64];
+	double chiSquare = 0.0;
+	const double expected = count / 64.0;
+	for (size_t i = 0; i < 64; ++i)
+		chiSquare += (buckets[i] - expected) * (buckets[i] - expected) / expected;
+	// 63 degrees of freedom, 0.1% of uniform distributions are above 104
+	CHECK(chiSquare < 104.0);
+}
+
+static void testHashDistribution()
+{
+	static const size_t CAPACITY = 8192;
+	static const size_t COUNT = CAPACITY / 2;
+	static LiveMemTracer::Hash hashes[COUNT];
+
+	// Return addresses, a few bytes apart in the same module
+	static LiveMemTracer::Dictionary<LiveMemTracer::Hash, int, CAPACITY> frames("TEST_FRAMES");
+	const uint64_t module = 0x00007FF6A1230000ULL;
+	int flippedBits = 0;
+	for (size_t i = 0; i < COUNT; ++i)
+	{
+		const uint64_t frame = module + i * 7;
+		hashes[i] = LiveMemTracer::combineHash(frame);
+		flippedBits += countBits(hashes[i] ^ LiveMemTracer::combineHash(frame ^ 1));
+	}
+	checkDistribution(hashes, COUNT, frames);
+	// A one bit change of the key flips half of the hash bits
+	const double averageFlipped = flippedBits / double(COUNT);
+	CHECK(averageFlipped > 28.0 && averageFlipped < 36.0);
+
+	// Stacks sharing their callers, different by their leaf frame only
+	static LiveMemTracer::Dictionary<LiveMemTracer::Hash, int, CAPACITY> stacks("TEST_STACKS");
+	void *stack[12];
+	for (size_t f = 1; f < 12; ++f)
+		stack[f] = (void*)(size_t(module) + 0x10000 + f * 0x120);
+	for (size_t i = 0; i < COUNT; ++i)
+	{
+		stack[0] = (void*)(size_t(module) + 0x40000 + i * 16);
+		hashes[i] = LiveMemTracer::hashCallstack(stack, 12);
+	}
+	checkDistribution(hashes, COUNT, stacks);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Folding
+
+static void *volatile g_sink = nullptr;
+
+extern "C" TEST_NOINLINE void *lmtFoldInner(size_t size)
+{
+	void *ptr = LMT_ALLOC(size);
+	g_sink = ptr;
+	return ptr;
+}
+
+extern "C" TEST_NOINLINE void *lmtFoldOuter(size_t size)
+{
+	void *ptr = lmtFoldInner(size);
+	g_sink = ptr;
+	return ptr;
+}
+
+static void testFolding()
+{
+	// Before the first call, rules are checked when a frame is first symbolized
+	LMT_FOLD_PREFIX("lmtFold");
+
+	void *ptr = lmtFoldOuter(1000);
+	LiveMemTracer::Alloc *inner = findAlloc("lmtFoldInner");
+	LiveMemTracer::Alloc *outer = findAlloc("lmtFoldOuter");
+	CHECK(inner != nullptr && inner->folded);
+	CHECK(outer != nullptr && outer->folded);
+	if (inner != nullptr && outer != nullptr)
+	{
+		// The run is collapsed into its outermost frame
+		CHECK(flushAndRead(outer->allocSize) == 1000);
+		CHECK(flushAndRead(inner->allocSize) == 0);
+		CHECK(flushAndRead(outer->edges) != LiveMemTracer::EDGE_NONE);
+		CHECK(flushAndRead(inner->edges) == LiveMemTracer::EDGE_NONE);
+	}
+
+	LMT_DEALLOC(ptr);
+	if (inner != nullptr && outer != nullptr)
+	{
+		CHECK(flushAndRead(outer->allocSize) == 0);
+		CHECK(flushAndRead(inner->allocSize) == 0);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Recursion
+
+extern "C" TEST_NOINLINE void *lmtTestRecurse(int depth, size_t size)
+{
+	void *ptr = depth == 0 ? LMT_ALLOC(size) : lmtTestRecurse(depth - 1, size);
+	g_sink = ptr;
+	return ptr;
+}
+
+static void testRecursionCollapse()
+{
+	// Same call site, both stacks have the same callers
+	void *ptrs[2];
+	for (int i = 0; i < 2; ++i)
+		ptrs[i] = lmtTestRecurse(10 * (i + 1), 100 * (i + 1));
+	LiveMemTracer::Alloc *recurse = findAlloc("lmtTestRecurse");
+	CHECK(recurse != nullptr);
+	if (recurse != nullptr)
+	{
+		// Both stacks end in the same node, sized once per allocation
+		CHECK(flushAndRead(recurse->allocSize) == 300);
+		std::lock_guard<std::mutex> lock(LiveMemTracer::g_mutex);
+		size_t nodes = 0;
+		uint8_t recursion = 0;
+		for (LiveMemTracer::EdgeIndex e = recurse->edges; e != LiveMemTracer::EDGE_NONE; e = LiveMemTracer::g_edges[e].same)
+		{
+			++nodes;
+			recursion = LiveMemTracer::g_edges[e].recursion;
+		}
+		CHECK(nodes == 1);
+		// Deepest run of the node, 21 frames
+		CHECK(recursion == 21);
+	}
+
+	LMT_DEALLOC(ptrs[0]);
+	LMT_DEALLOC(ptrs[1]);
+	if (recurse != nullptr)
+		CHECK(flushAndRead(recurse->allocSize) == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Lifetimes
+
+struct LifetimeTotals
+{
+	uint64_t counts[LiveMemTracer::LIFETIME_BUCKET_NUMBER];
+	uint64_t bytes;
+};
+
+static LifetimeTotals getLifetimeTotals()
+{
+	LMT_FLUSH();
+	std::lock_guard<std::mutex> lock(LiveMemTracer::g_mutex);
+	LifetimeTotals totals = {};
+	for (LiveMemTracer::AllocStack *stack = LiveMemTracer::g_allocStackList; stack != nullptr; stack = stack->next)
+	{
+		for (uint8_t i = 0; i < LiveMemTracer::LIFETIME_BUCKET_NUMBER; ++i)
+		{
+			totals.counts[i] += stack->lifetimes[i];
+			totals.bytes += stack->lifetimeBytes[i];
+		}
+	}
+	return totals;
+}
+
+static void testLifetimes()
+{
+	const LifetimeTotals before = getLifetimeTotals();
+	for (int i = 0; i < 100; ++i)
+		LMT_DEALLOC(LMT_ALLOC(32));
+	const LifetimeTotals shortLived = getLifetimeTotals();
+
+	void *ptr = LMT_ALLOC(64);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	LMT_DEALLOC(ptr);
+	const LifetimeTotals longLived = getLifetimeTotals();
+
+	uint64_t shortCount = 0;
+	uint64_t longCount = 0;
+	uint8_t shortBucket = 0;
+	uint8_t longBucket = 0;
+	for (uint8_t i = 0; i < LiveMemTracer::LIFETIME_BUCKET_NUMBER; ++i)
+	{
+		const uint64_t shortFrees = shortLived.counts[i] - before.counts[i];
+		const uint64_t longFrees = longLived.counts[i] - shortLived.counts[i];
+		if (shortFrees > shortLived.counts[shortBucket] - before.counts[shortBucket])
+			shortBucket = i;
+		if (longFrees != 0)
+			longBucket = i;
+		shortCount += shortFrees;
+		longCount += longFrees;
+	}
+	CHECK(shortCount == 100);
+	CHECK(shortLived.bytes - before.bytes == 100 * 32);
+	CHECK(longCount == 1);
+	CHECK(longLived.bytes - shortLived.bytes == 64);
+	// Log2 buckets, 50 ms are far above an immediate free
+	CHECK(longBucket > shortBucket);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Peak
+
+static void testPeak()
+{
+	static char memory[1024];
+	LMT_REGISTER_POOL(3, "TestPeak", memory, sizeof(memory));
+	const ptrdiff_t liveBefore = flushAndRead(LiveMemTracer::g_liveSize);
+	const ptrdiff_t peakBefore = flushAndRead(LiveMemTracer::g_peakSize);
+
+	void *ptr = LMT_ALLOC(4096);
+	CHECK(flushAndRead(LiveMemTracer::g_liveSize) - liveBefore == 4096);
+	CHECK(flushAndRead(LiveMemTracer::g_peakSize) >= liveBefore + 4096);
+
+	// Pools and resources are not part of the heap peak
+	LMT_POOL_ALLOC(3, memory, sizeof(memory));
+	LMT_TRACK_RESOURCE(1, 42, 1 << 20);
+	CHECK(flushAndRead(LiveMemTracer::g_liveSize) - liveBefore == 4096);
+	CHECK(flushAndRead(LiveMemTracer::g_peakSize) == std::max(peakBefore, liveBefore + 4096));
+	LMT_POOL_FREE(3, memory);
+	LMT_UNTRACK_RESOURCE(1, 42);
+
+	LMT_DEALLOC(ptr);
+	CHECK(flushAndRead(LiveMemTracer::g_liveSize) == liveBefore);
+	CHECK(flushAndRead(LiveMemTracer::g_peakSize) >= liveBefore + 4096);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Generations
+
+static void testGenerations()
+{
+	void *older = LMT_ALLOC(700);
+	const uint32_t generation = LMT_MARK();
+	LMT_FLUSH();
+	CHECK(LMT_LIVE_SINCE_MARK(generation) == 0);
+
+	void *kept = LMT_ALLOC(300);
+	LMT_DEALLOC(LMT_ALLOC(500));
+	// Frees are credited to the generation of their allocation
+	LMT_DEALLOC(older);
+	LMT_FLUSH();
+	CHECK(LMT_LIVE_SINCE_MARK(generation) == 300);
+
+	const uint32_t next = LMT_MARK();
+	CHECK(next > generation);
+	void *newer = LMT_ALLOC(40);
+	LMT_FLUSH();
+	CHECK(LMT_LIVE_SINCE_MARK(next) == 40);
+	CHECK(LMT_LIVE_SINCE_MARK(generation) == 340);
+
+	// Generations out of the ring are merged, asking for one of them counts them all
+	uint32_t last = next;
+	for (int i = 0; i < LMT_GENERATION_NUMBER * 2; ++i)
+		last = LMT_MARK();
+	void *latest = LMT_ALLOC(8);
+	LMT_FLUSH();
+	CHECK(LMT_LIVE_SINCE_MARK(last) == 8);
+	CHECK(LMT_LIVE_SINCE_MARK(generation) >= 348);
+
+	LMT_DEALLOC(kept);
+	LMT_DEALLOC(newer);
+	LMT_DEALLOC(latest);
+	LMT_FLUSH();
+	CHECK(LMT_LIVE_SINCE_MARK(last) == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Leak report
+
+extern "C" TEST_NOINLINE void *lmtTestLeak(size_t size)
+{
+	void *ptr = LMT_ALLOC(size);
+	g_sink = ptr;
+	return ptr;
+}
+
+// Returns the number of bytes read, the buffer is null terminated
+static size_t readFile(const char *path, char *buffer, size_t size)
+{
+	FILE *file = fopen(path, "r");
+	if (file == nullptr)
+		return 0;
+	const size_t read = fread(buffer, 1, size - 1, file);
+	buffer[read] = 0;
+	fclose(file);
+	return read;
+}
+
+static void testLeakReport()
+{
+	const char *path = "LMT_TestLeakReport.txt";
+	static char report[64 * 1024];
+
+	void *leaked = lmtTestLeak(1234);
+	LMT_FLUSH();
+	int expectedStacks = 0;
+	long long expectedBytes = 0;
+	{
+		std::lock_guard<std::mutex> lock(LiveMemTracer::g_mutex);
+		for (LiveMemTracer::AllocStack *stack = LiveMemTracer::g_allocStackList; stack != nullptr; stack = stack->next)
+		{
+			if (stack->allocSize == 0)
+				continue;
+			++expectedStacks;
+			expectedBytes += stack->allocSize;
+		}
+	}
+
+	CHECK(LMT_WRITE_LEAK_REPORT(path));
+	CHECK(readFile(path, report, sizeof(report)) > 0);
+	int stacks = 0;
+	long long bytes = 0;
+	CHECK(sscanf(report, "LiveMemTracer : %i stacks still hold %lld bytes", &stacks, &bytes) == 2);
+	CHECK(stacks == expectedStacks && stacks >= 1);
+	CHECK(bytes == expectedBytes && bytes >= 1234);
+	CHECK(strstr(report, "\n1234 bytes\n") != nullptr);
+	CHECK(strstr(report, "    lmtTestLeak\n") != nullptr);
+
+	// Freed stacks are not reported anymore
+	LMT_DEALLOC(leaked);
+	LMT_FLUSH();
+	CHECK(LMT_WRITE_LEAK_REPORT(path));
+	CHECK(readFile(path, report, sizeof(report)) > 0);
+	CHECK(strstr(report, "    lmtTestLeak\n") == nullptr);
+	remove(path);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Live table
+
+static size_t countOccurrences(const char *str, const char *pattern)
+{
+	size_t count = 0;
+	for (const char *found = strstr(str, pattern); found != nullptr; found = strstr(found + 1, pattern))
+		++count;
+	return count;
+}
+
+static size_t liveTableSize()
+{
+	LMT_FLUSH();
+	std::lock_guard<std::mutex> lock(LiveMemTracer::g_mutex);
+	return LiveMemTracer::g_liveTable.size();
+}
+
+static void testLiveTable()
+{
+	const size_t before = liveTableSize();
+
+	void *ptrs[10];
+	for (int i = 0; i < 10; ++i)
+		ptrs[i] = LMT_ALLOC(4321);
+	LMT_FLUSH();
+	{
+		std::lock_guard<std::mutex> lock(LiveMemTracer::g_mutex);
+		CHECK(LiveMemTracer::g_liveTable.size() - before == 10);
+		const LiveMemTracer::LiveTable<LMT_LIVE_TABLE_SIZE>::Entry *entry = LiveMemTracer::g_liveTable.find(ptrs[0], LiveMemTracer::DefaultHeap::ID);
+		CHECK(entry != nullptr && entry->size == 4321 && !entry->freed && entry->stack != 0);
+	}
+
+	// Every live allocation is in the dump
+	const char *path = "LMT_TestHeap.csv";
+	static char dump[256 * 1024];
+	CHECK(LMT_DUMP_HEAP(path));
+	CHECK(readFile(path, dump, sizeof(dump)) > 0);
+	CHECK(countOccurrences(dump, ",4321,") == 10);
+	remove(path);
+
+	for (int i = 0; i < 10; ++i)
+		LMT_DEALLOC(ptrs[i]);
+	CHECK(liveTableSize() == before);
+
+	// Allocations of another thread are treated after their frees,
+	// the frees wait in the table until the allocations come
+	static const int COUNT = 1000;
+	static void *shared[COUNT];
+	std::atomic<int> step(0);
+	std::thread thread([&]{
+		for (int i = 0; i < COUNT; ++i)
+			shared[i] = LMT_ALLOC(16);
+		step = 1;
+		while (step != 2)
+			std::this_thread::yield();
+		LMT_FLUSH();
+		step = 3;
+	});
+	while (step != 1)
+		std::this_thread::yield();
+	for (int i = 0; i < COUNT; ++i)
+		LMT_DEALLOC(shared[i]);
+	CHECK(flushAndRead(LiveMemTracer::g_liveFreedCount) == COUNT);
+	CHECK(liveTableSize() - before == COUNT);
+	step = 2;
+	thread.join();
+	CHECK(flushAndRead(LiveMemTracer::g_liveFreedCount) == 0);
+	CHECK(liveTableSize() == before);
+}
+
+int main()
+{
+	LMT_INIT();
+
+	testAllocationApi();
+	testHeapPolicies();
+	testTags();
+	testPools();
+	testResources();
+	testHashDistribution();
+	testFolding();
+	testRecursionCollapse();
+	testLifetimes();
+	testPeak();
+	testGenerations();
+	testLeakReport();
+	testLiveTable();
+
+	LMT_EXIT();
+	printf("%d failed check(s)\n", g_failures);
+	return g_failures;
+}